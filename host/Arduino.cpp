@@ -0,0 +1,505 @@
+/*
+ * Host Arduino shim: time, GPIO, RMT, Serial and FreeRTOS on POSIX threads
+ */
+#include "Arduino.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <malloc.h>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+#include <sys/prctl.h>
+#include <unistd.h>
+
+// ============================================================================
+// TIME AND GPIO
+// ============================================================================
+static const std::chrono::steady_clock::time_point bootTime = std::chrono::steady_clock::now();
+
+unsigned long millis() {
+    return (unsigned long)std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - bootTime).count();
+}
+
+static unsigned long clockMicros() {
+    return (unsigned long)std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - bootTime).count();
+}
+
+unsigned long hostMicrosAt(std::chrono::steady_clock::time_point time) {
+    return (unsigned long)std::chrono::duration_cast<std::chrono::microseconds>(time - bootTime).count();
+}
+
+void delay(uint32_t ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+// Busy-wait like the ROM routine, so replay timing keeps its shape
+void delayMicroseconds(uint32_t us) {
+    unsigned long start = micros();
+    while(micros() - start < us) {}
+}
+
+static uint8_t pinModes[HOST_GPIO_COUNT];
+static std::atomic<uint8_t> pinOutputs[HOST_GPIO_COUNT];     // Also driven by RMT players
+static std::atomic<bool> pinInputsLow[HOST_GPIO_COUNT];      // Inputs idle HIGH
+static uint8_t loopbackInputs[HOST_GPIO_COUNT];              // Input pin + 1, 0 = none
+static bool loopbackInverted[HOST_GPIO_COUNT];
+static int32_t loopbackSkewUs[HOST_GPIO_COUNT];              // Added to marks at the input
+static std::atomic<void (*)(void)> pinInterrupts[HOST_GPIO_COUNT];
+static std::atomic<int> pinInterruptModes[HOST_GPIO_COUNT];
+
+/*
+ * Simulated input clock
+ *
+ * Whoever drives an input (an RMT player through a loopback, a --pattern
+ * thread) knows when each edge is due. It records the edge with that
+ * time in the pin's edge log instead of the moment its thread got to run.
+ * A thread polling the input then sees every edge in order, one per
+ * digitalRead(), even if it was preempted past several of them. The
+ * micros() call that follows returns the edge's own time. Between edges,
+ * micros() does not run past the next edge the thread has yet to read,
+ * so silence timeouts do not fire on a backlog. Captured timings then
+ * equal the driven ones exactly, whatever the host scheduler does.
+ *
+ * A thread that has not read a pin for EDGE_STALE_US starts from the
+ * pin's current level again, like a receiver that was not listening.
+ *
+ * With hostRealTimeInputs set, due times are ignored: a level changes
+ * when the driving thread gets to it, digitalRead() sees only the current
+ * level and micros() is the plain clock. Captures then carry the host's
+ * scheduling jitter, on both the driving and the polling side.
+ */
+bool hostRealTimeInputs = false;
+
+#define EDGE_LOG_SIZE 4096              // Edges kept per input pin (power of two)
+#define EDGE_STALE_US 200000
+
+struct Edge {
+    unsigned long time;
+    bool low;
+};
+
+struct EdgeLog {
+    std::mutex lock;
+    Edge edges[EDGE_LOG_SIZE];
+    uint64_t count = 0;                 // Edges ever logged
+};
+
+// What one thread has read of each input
+struct EdgeReader {
+    uint64_t cursor[HOST_GPIO_COUNT] = {};      // Next edge to read
+    unsigned long lastRead[HOST_GPIO_COUNT] = {};
+    bool low[HOST_GPIO_COUNT] = {};             // Level after the last edge read
+    uint64_t watching = 0;                      // Pins read within EDGE_STALE_US
+    bool edgeRead = false;                      // The next micros() returns edgeTime
+    unsigned long edgeTime = 0;
+};
+
+static EdgeLog edgeLogs[HOST_GPIO_COUNT];
+static thread_local EdgeReader edgeReader;
+static thread_local bool inEdgeHandler = false;  // Interrupt handler running for an edge
+static thread_local unsigned long edgeHandlerTime = 0;
+
+unsigned long micros() {
+    if(hostRealTimeInputs) return clockMicros();
+    if(inEdgeHandler) return edgeHandlerTime;
+    EdgeReader& reader = edgeReader;
+    if(reader.edgeRead) {
+        reader.edgeRead = false;
+        return reader.edgeTime;
+    }
+
+    unsigned long now = clockMicros();
+    unsigned long clock = now;
+    for(uint8_t pin = 0; reader.watching >> pin; pin++) {
+        if(!(reader.watching >> pin & 1)) continue;
+        if(now - reader.lastRead[pin] > EDGE_STALE_US) {
+            reader.watching &= ~(1ULL << pin);
+            continue;
+        }
+        EdgeLog& log = edgeLogs[pin];
+        std::lock_guard<std::mutex> guard(log.lock);
+        if(reader.cursor[pin] < log.count) {
+            clock = min(clock, log.edges[reader.cursor[pin] & (EDGE_LOG_SIZE - 1)].time);
+        }
+    }
+    return clock;
+}
+
+// Next level of an input for the calling thread, see "Simulated input clock"
+static bool readEdgeLog(uint8_t pin) {
+    EdgeReader& reader = edgeReader;
+    EdgeLog& log = edgeLogs[pin];
+    unsigned long now = clockMicros();
+    std::lock_guard<std::mutex> guard(log.lock);
+
+    bool stale = !(reader.watching >> pin & 1) || now - reader.lastRead[pin] > EDGE_STALE_US ||
+                 log.count - reader.cursor[pin] > EDGE_LOG_SIZE;
+    if(stale) {
+        reader.cursor[pin] = log.count;
+        reader.low[pin] = pinInputsLow[pin];
+    }
+    reader.watching |= 1ULL << pin;
+    reader.lastRead[pin] = now;
+
+    if(reader.cursor[pin] < log.count) {
+        const Edge& edge = log.edges[reader.cursor[pin]++ & (EDGE_LOG_SIZE - 1)];
+        reader.low[pin] = edge.low;
+        reader.edgeRead = true;
+        reader.edgeTime = edge.time;
+    }
+    return reader.low[pin];
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+    if(pin < HOST_GPIO_COUNT) pinModes[pin] = mode;
+}
+
+// An output level change due at time; loopbacks pass it on with that time.
+// A skewed loopback moves mark starts (positive skew) or mark ends
+// (negative) that much earlier, so the input sees every mark longer or
+// shorter by the skew and every space the other way.
+static void writePin(uint8_t pin, uint8_t value, unsigned long time) {
+    if(pin >= HOST_GPIO_COUNT) return;
+    pinOutputs[pin] = value ? HIGH : LOW;
+    if(loopbackInputs[pin]) {
+        int32_t skew = loopbackSkewUs[pin];
+        if(value ? skew > 0 : skew < 0) time -= abs(skew);
+        hostSetPinLevel(loopbackInputs[pin] - 1, (value != 0) != loopbackInverted[pin] ? HIGH : LOW, time);
+    }
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+    writePin(pin, value, clockMicros());
+}
+
+// Capture loops poll inputs flat out. On the device the receiver and RMT
+// run beside them; here the threads standing in for those need the CPU,
+// so polling an input sleeps for a few microseconds, with the timer slack
+// cut so the poll interval stays well under the capture filters.
+int digitalRead(uint8_t pin) {
+    if(pin >= HOST_GPIO_COUNT) return LOW;
+    if(pinModes[pin] == OUTPUT) return pinOutputs[pin];
+    static thread_local bool slackSet = false;
+    if(!slackSet) {
+        prctl(PR_SET_TIMERSLACK, 1000UL);
+        slackSet = true;
+    }
+    std::this_thread::sleep_for(std::chrono::microseconds(2));
+    if(hostRealTimeInputs) return pinInputsLow[pin] ? LOW : HIGH;
+    return readEdgeLog(pin) ? LOW : HIGH;
+}
+
+void attachInterrupt(uint8_t pin, void (*handler)(void), int mode) {
+    if(pin >= HOST_GPIO_COUNT) return;
+    pinInterruptModes[pin] = mode;
+    pinInterrupts[pin] = handler;
+}
+
+void detachInterrupt(uint8_t pin) {
+    if(pin < HOST_GPIO_COUNT) pinInterrupts[pin] = NULL;
+}
+
+void hostSetPinLevel(uint8_t pin, uint8_t value, unsigned long time) {
+    if(pin >= HOST_GPIO_COUNT) return;
+    bool low = !value;
+    EdgeLog& log = edgeLogs[pin];
+    {
+        std::lock_guard<std::mutex> guard(log.lock);
+        if(pinInputsLow[pin].exchange(low) == low) return;
+        if(!time || hostRealTimeInputs) time = clockMicros();
+        log.edges[log.count++ & (EDGE_LOG_SIZE - 1)] = Edge{time, low};
+    }
+
+    // The handler's micros() reads the edge time, as the ISR would see it
+    void (*handler)(void) = pinInterrupts[pin];
+    int mode = pinInterruptModes[pin];
+    if(handler && (mode == CHANGE || (mode == FALLING) == low)) {
+        inEdgeHandler = true;
+        edgeHandlerTime = time;
+        handler();
+        inEdgeHandler = false;
+    }
+}
+
+void hostLoopback(uint8_t outputPin, uint8_t inputPin, bool inverted, int32_t skewUs) {
+    if(outputPin >= HOST_GPIO_COUNT || inputPin >= HOST_GPIO_COUNT) return;
+    loopbackInputs[outputPin] = inputPin + 1;
+    loopbackInverted[outputPin] = inverted;
+    loopbackSkewUs[outputPin] = skewUs;
+}
+
+// ============================================================================
+// RMT
+// ============================================================================
+struct HostRmtChannel {
+    bool initialized = false;
+    uint32_t frequency = 1000000;
+    uint8_t eotLevel = LOW;
+    std::thread player;
+    std::atomic<bool> playing{false};
+    std::atomic<bool> abort{false};
+};
+
+static HostRmtChannel rmtChannels[HOST_GPIO_COUNT];
+
+static void rmtStop(HostRmtChannel& channel) {
+    channel.abort = true;
+    if(channel.player.joinable()) channel.player.join();
+    channel.abort = false;
+    channel.playing = false;
+}
+
+bool rmtInit(int pin, rmt_ch_dir_t direction, rmt_reserve_memsize_t memsize, uint32_t frequency_Hz) {
+    (void)memsize;
+    if(pin < 0 || pin >= HOST_GPIO_COUNT || direction != RMT_TX_MODE || frequency_Hz == 0) return false;
+    HostRmtChannel& channel = rmtChannels[pin];
+    rmtStop(channel);
+    channel.initialized = true;
+    channel.frequency = frequency_Hz;
+    pinMode(pin, OUTPUT);
+    digitalWrite(pin, channel.eotLevel);
+    return true;
+}
+
+bool rmtDeinit(int pin) {
+    if(pin < 0 || pin >= HOST_GPIO_COUNT || !rmtChannels[pin].initialized) return false;
+    rmtStop(rmtChannels[pin]);
+    rmtChannels[pin].initialized = false;
+    return true;
+}
+
+bool rmtSetEOT(int pin, uint8_t EOT_Level) {
+    if(pin < 0 || pin >= HOST_GPIO_COUNT || !rmtChannels[pin].initialized) return false;
+    rmtChannels[pin].eotLevel = EOT_Level ? HIGH : LOW;
+    return true;
+}
+
+bool rmtSetCarrier(int pin, bool carrier_en, bool carrier_level, uint32_t frequency_Hz, float duty_percent) {
+    (void)carrier_level;
+    if(pin < 0 || pin >= HOST_GPIO_COUNT || !rmtChannels[pin].initialized || rmtChannels[pin].playing) return false;
+    return !carrier_en || (frequency_Hz > 0 && duty_percent > 0 && duty_percent < 1);
+}
+
+// Like the driver, data must stay valid until the frame completes
+bool rmtWriteAsync(int pin, rmt_data_t* data, size_t num_rmt_symbols) {
+    if(pin < 0 || pin >= HOST_GPIO_COUNT) return false;
+    HostRmtChannel& channel = rmtChannels[pin];
+    if(!channel.initialized || channel.playing) return false;
+    if(channel.player.joinable()) channel.player.join();
+
+    channel.playing = true;
+    channel.player = std::thread([pin, data, num_rmt_symbols, &channel]() {
+        using namespace std::chrono;
+        prctl(PR_SET_TIMERSLACK, 1000UL);      // Default 50 us slack would smear edges
+        // Levels carry the time they are due, see "Simulated input clock"
+        steady_clock::time_point edge = steady_clock::now();
+        auto play = [&](uint32_t duration, uint32_t level) {
+            if(duration == 0) return false;     // End marker
+            writePin(pin, level, hostMicrosAt(edge));
+            edge += nanoseconds((uint64_t)duration * 1000000000ULL / channel.frequency);
+            std::this_thread::sleep_until(edge);
+            return !channel.abort;
+        };
+        for(size_t i = 0; i < num_rmt_symbols; i++) {
+            if(!play(data[i].duration0, data[i].level0) || !play(data[i].duration1, data[i].level1)) break;
+        }
+        writePin(pin, channel.eotLevel, channel.abort ? clockMicros() : hostMicrosAt(edge));
+        channel.playing = false;
+    });
+    return true;
+}
+
+bool rmtTransmitCompleted(int pin) {
+    if(pin < 0 || pin >= HOST_GPIO_COUNT) return false;
+    return rmtChannels[pin].initialized && !rmtChannels[pin].playing;
+}
+
+uint32_t esp_random() {
+    static std::mutex lock;
+    static std::mt19937 generator(std::random_device{}());
+    std::lock_guard<std::mutex> guard(lock);
+    return generator();
+}
+
+EspClass ESP;
+
+uint32_t EspClass::getFreeHeap() {
+    return mallinfo2().fordblks;
+}
+
+// ============================================================================
+// SERIAL
+// ============================================================================
+HardwareSerial Serial;
+
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size) {
+    return fwrite(buffer, 1, size, stdout);
+}
+
+size_t Print::printf(const char* format, ...) {
+    char buffer[256];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    if(length < 0) return 0;
+    return write(buffer, min((size_t)length, sizeof(buffer) - 1));
+}
+
+// ============================================================================
+// FREERTOS
+// ============================================================================
+struct HostTask {
+    std::mutex lock;
+    std::condition_variable wake;
+    uint32_t notifications = 0;
+};
+
+struct HostQueue {
+    std::mutex lock;
+    std::condition_variable changed;
+    std::deque<std::vector<uint8_t>> items;
+    size_t length;
+    size_t itemSize;
+};
+
+// Counting semaphore; a mutex starts full, a binary semaphore empty
+struct HostSemaphore {
+    std::mutex lock;
+    std::condition_variable changed;
+    uint32_t count;
+    uint32_t limit;
+};
+
+static HostTask mainTask;
+static thread_local HostTask* currentTask = &mainTask;
+
+// Deadline for a tick timeout; portMAX_DELAY waits forever
+static std::chrono::steady_clock::time_point deadlineAfter(TickType_t ticks) {
+    if(ticks == portMAX_DELAY) return std::chrono::steady_clock::time_point::max();
+    return std::chrono::steady_clock::now() + std::chrono::milliseconds(ticks);
+}
+
+BaseType_t xTaskCreate(TaskFunction_t task, const char* name, uint32_t stackSize,
+                       void* parameter, UBaseType_t priority, TaskHandle_t* handle) {
+    return xTaskCreatePinnedToCore(task, name, stackSize, parameter, priority, handle, tskNO_AFFINITY);
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t task, const char* name, uint32_t stackSize,
+                                   void* parameter, UBaseType_t priority, TaskHandle_t* handle,
+                                   BaseType_t core) {
+    (void)name; (void)stackSize; (void)priority; (void)core;
+    HostTask* created = new HostTask();
+    if(handle) *handle = created;
+    std::thread([task, parameter, created]() {
+        currentTask = created;
+        task(parameter);
+    }).detach();
+    return pdPASS;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle() {
+    return currentTask;
+}
+
+void vTaskDelay(TickType_t ticks) {
+    delay(ticks);
+}
+
+TickType_t xTaskGetTickCount() {
+    return (TickType_t)millis();
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task) {
+    (void)task;
+    return 0;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+    std::lock_guard<std::mutex> guard(task->lock);
+    task->notifications++;
+    task->wake.notify_one();
+    return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* higherPriorityTaskWoken) {
+    xTaskNotifyGive(task);
+    if(higherPriorityTaskWoken) *higherPriorityTaskWoken = pdTRUE;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t timeout) {
+    HostTask* task = currentTask;
+    std::unique_lock<std::mutex> guard(task->lock);
+    task->wake.wait_until(guard, deadlineAfter(timeout), [task]() { return task->notifications > 0; });
+    uint32_t value = task->notifications;
+    if(value > 0) task->notifications = clearOnExit ? 0 : value - 1;
+    return value;
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize) {
+    HostQueue* queue = new HostQueue();
+    queue->length = length;
+    queue->itemSize = itemSize;
+    return queue;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t timeout) {
+    std::unique_lock<std::mutex> guard(queue->lock);
+    if(!queue->changed.wait_until(guard, deadlineAfter(timeout),
+                                  [queue]() { return queue->items.size() < queue->length; })) {
+        return pdFALSE;
+    }
+    const uint8_t* bytes = (const uint8_t*)item;
+    queue->items.emplace_back(bytes, bytes + queue->itemSize);
+    queue->changed.notify_all();
+    return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t timeout) {
+    std::unique_lock<std::mutex> guard(queue->lock);
+    if(!queue->changed.wait_until(guard, deadlineAfter(timeout),
+                                  [queue]() { return !queue->items.empty(); })) {
+        return pdFALSE;
+    }
+    memcpy(item, queue->items.front().data(), queue->itemSize);
+    queue->items.pop_front();
+    queue->changed.notify_all();
+    return pdTRUE;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue) {
+    std::lock_guard<std::mutex> guard(queue->lock);
+    return queue->items.size();
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex() {
+    return new HostSemaphore{{}, {}, 1, 1};
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary() {
+    return new HostSemaphore{{}, {}, 0, 1};
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t timeout) {
+    std::unique_lock<std::mutex> guard(semaphore->lock);
+    if(!semaphore->changed.wait_until(guard, deadlineAfter(timeout),
+                                      [semaphore]() { return semaphore->count > 0; })) {
+        return pdFALSE;
+    }
+    semaphore->count--;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) {
+    std::lock_guard<std::mutex> guard(semaphore->lock);
+    if(semaphore->count == semaphore->limit) return pdFALSE;
+    semaphore->count++;
+    semaphore->changed.notify_one();
+    return pdTRUE;
+}
@@ -0,0 +1,244 @@
+/*
+ * Host Arduino shim
+ *
+ * Just enough of the Arduino-ESP32 core for main.cpp to build and run on
+ * Linux: String, Serial on stdout, millis/micros on the monotonic clock,
+ * simulated GPIO levels, an RMT transmitter and FreeRTOS tasks, queues and mutexes on threads.
+ * Only the calls the firmware actually makes are provided.
+ */
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdarg>
+#include <string>
+#include <algorithm>
+#include <chrono>
+
+#define PROGMEM
+#define PGM_P const char*
+#define IRAM_ATTR
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define RISING 0x01
+#define FALLING 0x02
+#define CHANGE 0x03
+
+typedef uint8_t byte;
+
+using std::min;
+using std::max;
+
+// ============================================================================
+// TIME AND GPIO
+// ============================================================================
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+
+#define HOST_GPIO_COUNT 40
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+
+// Handlers run on the thread that changes the input level, standing in for the ISR
+#define digitalPinToInterrupt(pin) (pin)
+void attachInterrupt(uint8_t pin, void (*handler)(void), int mode);
+void detachInterrupt(uint8_t pin);
+
+// Level an input pin reads; inputs idle HIGH like the receivers' outputs.
+// time is the micros() at which the change is due (0 = now); readers see
+// it at that time whenever this call gets to run.
+void hostSetPinLevel(uint8_t pin, uint8_t value, unsigned long time = 0);
+
+// micros() value of a point on the monotonic clock
+unsigned long hostMicrosAt(std::chrono::steady_clock::time_point time);
+
+// Wire an output pin to an input pin, inverted for active-low receivers;
+// every level written to the output, by digitalWrite or RMT, reaches it.
+// skewUs lengthens (or, negative, shortens) each mark the input sees by
+// that much and the spaces the other way, standing in for receiver bias.
+// It must stay under the shortest space (mark) and needs scheduled inputs.
+void hostLoopback(uint8_t outputPin, uint8_t inputPin, bool inverted, int32_t skewUs = 0);
+
+// Inputs change when their driving thread runs instead of at their due
+// time; see "Simulated input clock" in Arduino.cpp
+extern bool hostRealTimeInputs;
+
+// ============================================================================
+// RMT
+// ============================================================================
+// Transmit only. A frame is played onto the pin's output level by a thread,
+// one symbol half at a time; the carrier setting is accepted and not modulated.
+typedef union {
+    struct {
+        uint32_t duration0 : 15;
+        uint32_t level0 : 1;
+        uint32_t duration1 : 15;
+        uint32_t level1 : 1;
+    };
+    uint32_t val;
+} rmt_data_t;
+
+typedef enum { RMT_RX_MODE = 0, RMT_TX_MODE = 1 } rmt_ch_dir_t;
+typedef enum {
+    RMT_MEM_NUM_BLOCKS_1 = 1,
+    RMT_MEM_NUM_BLOCKS_2 = 2,
+    RMT_MEM_NUM_BLOCKS_3 = 3,
+    RMT_MEM_NUM_BLOCKS_4 = 4
+} rmt_reserve_memsize_t;
+
+bool rmtInit(int pin, rmt_ch_dir_t direction, rmt_reserve_memsize_t memsize, uint32_t frequency_Hz);
+bool rmtDeinit(int pin);
+bool rmtSetEOT(int pin, uint8_t EOT_Level);
+bool rmtSetCarrier(int pin, bool carrier_en, bool carrier_level, uint32_t frequency_Hz, float duty_percent);
+bool rmtWriteAsync(int pin, rmt_data_t* data, size_t num_rmt_symbols);
+bool rmtTransmitCompleted(int pin);
+
+uint32_t esp_random();
+
+class EspClass {
+public:
+    uint32_t getFreeHeap();
+};
+
+extern EspClass ESP;
+
+// ============================================================================
+// STRING AND PRINT
+// ============================================================================
+class String {
+public:
+    String() {}
+    String(const char* value) : value(value ? value : "") {}
+    String(const std::string& value) : value(value) {}
+    String(char c) : value(1, c) {}
+    String(int number) : value(std::to_string(number)) {}
+    String(unsigned int number) : value(std::to_string(number)) {}
+    String(long number) : value(std::to_string(number)) {}
+    String(unsigned long number) : value(std::to_string(number)) {}
+
+    const char* c_str() const { return value.c_str(); }
+    unsigned int length() const { return value.size(); }
+    bool isEmpty() const { return value.empty(); }
+    long toInt() const { return strtol(value.c_str(), NULL, 10); }
+
+    String& operator+=(const String& other) { value += other.value; return *this; }
+    String& operator+=(const char* other) { value += other; return *this; }
+    String& operator+=(char c) { value += c; return *this; }
+
+    bool operator==(const String& other) const { return value == other.value; }
+    bool operator==(const char* other) const { return value == other; }
+    bool operator!=(const String& other) const { return value != other.value; }
+    bool operator!=(const char* other) const { return value != other; }
+
+    bool equalsIgnoreCase(const String& other) const { return strcasecmp(c_str(), other.c_str()) == 0; }
+
+    friend String operator+(const String& a, const String& b) { return String(a.value + b.value); }
+    friend String operator+(const char* a, const String& b) { return String(a + b.value); }
+    friend String operator+(const String& a, const char* b) { return String(a.value + b); }
+
+private:
+    std::string value;
+};
+
+class Print;
+
+class Printable {
+public:
+    virtual ~Printable() {}
+    virtual size_t printTo(Print& p) const = 0;
+};
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(const uint8_t* buffer, size_t size) = 0;
+
+    size_t write(uint8_t c) { return write(&c, 1); }
+    size_t write(const char* buffer, size_t size) { return write((const uint8_t*)buffer, size); }
+
+    size_t print(const char* text) { return write(text, strlen(text)); }
+    size_t print(const String& text) { return write(text.c_str(), text.length()); }
+    size_t print(const Printable& item) { return item.printTo(*this); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(long number) { return printf("%ld", number); }
+    size_t print(unsigned long number) { return printf("%lu", number); }
+    size_t print(int number) { return print((long)number); }
+    size_t print(unsigned int number) { return print((unsigned long)number); }
+
+    template<typename T>
+    size_t println(const T& item) { return print(item) + println(); }
+    size_t println() { return write("\r\n", 2); }
+
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+};
+
+class HardwareSerial : public Print {
+public:
+    void begin(unsigned long baud) { (void)baud; }
+    int availableForWrite() { return 4096; }
+    size_t write(const uint8_t* buffer, size_t size) override;
+    using Print::write;
+};
+
+extern HardwareSerial Serial;
+
+// ============================================================================
+// FREERTOS
+// ============================================================================
+// Tasks are threads; priorities and core affinity are accepted and ignored.
+// One tick is one millisecond.
+typedef struct HostTask* TaskHandle_t;
+typedef struct HostQueue* QueueHandle_t;
+typedef struct HostSemaphore* SemaphoreHandle_t;
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef void (*TaskFunction_t)(void*);
+
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+#define portTICK_PERIOD_MS 1
+#define portMAX_DELAY ((TickType_t)0xffffffffUL)
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS 1
+#define pdFAIL 0
+#define tskIDLE_PRIORITY 0
+#define tskNO_AFFINITY 0x7fffffff
+#define configMAX_PRIORITIES 25
+#define PRO_CPU_NUM 0
+#define APP_CPU_NUM 1
+
+BaseType_t xTaskCreate(TaskFunction_t task, const char* name, uint32_t stackSize,
+                       void* parameter, UBaseType_t priority, TaskHandle_t* handle);
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t task, const char* name, uint32_t stackSize,
+                                   void* parameter, UBaseType_t priority, TaskHandle_t* handle,
+                                   BaseType_t core);
+TaskHandle_t xTaskGetCurrentTaskHandle();
+void vTaskDelay(TickType_t ticks);
+TickType_t xTaskGetTickCount();
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task);
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* higherPriorityTaskWoken);
+#define portYIELD_FROM_ISR(woken) ((void)(woken))
+uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t timeout);
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize);
+BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t timeout);
+BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t timeout);
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue);
+
+SemaphoreHandle_t xSemaphoreCreateMutex();
+SemaphoreHandle_t xSemaphoreCreateBinary();
+BaseType_t xSemaphoreTake(SemaphoreHandle_t mutex, TickType_t timeout);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t mutex);
@@ -0,0 +1,130 @@
+/*
+ * Host FS shim: LittleFS paths mapped onto a host directory
+ */
+#include "LittleFS.h"
+
+#include <dirent.h>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+
+struct File::Impl {
+    std::string path;       // Path as seen by the firmware
+    std::string name;
+    std::string hostPath;
+    FILE* file = NULL;
+    DIR* dir = NULL;
+
+    ~Impl() {
+        if(file) fclose(file);
+        if(dir) closedir(dir);
+    }
+};
+
+size_t File::write(const uint8_t* buffer, size_t size) {
+    return impl && impl->file ? fwrite(buffer, 1, size, impl->file) : 0;
+}
+
+size_t File::read(uint8_t* buffer, size_t size) {
+    return impl && impl->file ? fread(buffer, 1, size, impl->file) : 0;
+}
+
+bool File::seek(uint32_t position, SeekMode mode) {
+    return impl && impl->file && fseek(impl->file, position, mode) == 0;
+}
+
+size_t File::position() const {
+    return impl && impl->file ? ftell(impl->file) : 0;
+}
+
+size_t File::size() const {
+    struct stat info;
+    if(!impl || stat(impl->hostPath.c_str(), &info) != 0) return 0;
+    return info.st_size;
+}
+
+int File::available() {
+    return impl && impl->file ? (int)(size() - position()) : 0;
+}
+
+void File::flush() {
+    if(impl && impl->file) fflush(impl->file);
+}
+
+const char* File::name() const {
+    return impl ? impl->name.c_str() : "";
+}
+
+const char* File::path() const {
+    return impl ? impl->path.c_str() : "";
+}
+
+bool File::isDirectory() const {
+    return impl && impl->dir;
+}
+
+File File::openNextFile(const char* mode) {
+    if(!isDirectory()) return File();
+    for(dirent* entry = readdir(impl->dir); entry; entry = readdir(impl->dir)) {
+        if(strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) continue;
+        std::string child = impl->path + (impl->path == "/" ? "" : "/") + entry->d_name;
+        return LittleFS.open(child.c_str(), mode);
+    }
+    return File();
+}
+
+namespace fs {
+
+String FS::hostPath(const char* path) {
+    return root + path;
+}
+
+File FS::open(const char* path, const char* mode, const bool create) {
+    (void)create;
+    String host = hostPath(path);
+    auto impl = std::make_shared<File::Impl>();
+    impl->path = path;
+    const char* slash = strrchr(path, '/');
+    impl->name = slash ? slash + 1 : path;
+    impl->hostPath = host.c_str();
+
+    struct stat info;
+    if(stat(host.c_str(), &info) == 0 && S_ISDIR(info.st_mode)) {
+        impl->dir = opendir(host.c_str());
+        return impl->dir ? File(impl) : File();
+    }
+
+    const char* hostMode = mode[0] == 'w' ? "wb" : mode[0] == 'a' ? "ab" : "rb";
+    impl->file = fopen(host.c_str(), hostMode);
+    return impl->file ? File(impl) : File();
+}
+
+bool FS::exists(const char* path) {
+    struct stat info;
+    return stat(hostPath(path).c_str(), &info) == 0;
+}
+
+bool FS::remove(const char* path) {
+    return unlink(hostPath(path).c_str()) == 0;
+}
+
+bool FS::mkdir(const char* path) {
+    return ::mkdir(hostPath(path).c_str(), 0755) == 0;
+}
+
+bool FS::rename(const char* from, const char* to) {
+    return ::rename(hostPath(from).c_str(), hostPath(to).c_str()) == 0;
+}
+
+}
+
+LittleFSFS LittleFS;
+
+bool LittleFSFS::begin(bool formatOnFail, const char* basePath, uint8_t maxOpenFiles, const char* partitionLabel) {
+    (void)formatOnFail; (void)basePath; (void)maxOpenFiles; (void)partitionLabel;
+    const char* directory = getenv("LITTLEFS_ROOT");
+    root = directory ? directory : "littlefs";
+    ::mkdir(root.c_str(), 0755);
+    struct stat info;
+    return stat(root.c_str(), &info) == 0 && S_ISDIR(info.st_mode);
+}
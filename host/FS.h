@@ -0,0 +1,56 @@
+/*
+ * Host FS shim
+ *
+ * Files live under a directory on the host file system (LITTLEFS_ROOT,
+ * default ./littlefs), so the persistent event log survives restarts of
+ * the host build just as it survives reboots on the device.
+ */
+#pragma once
+
+#include "Arduino.h"
+#include <memory>
+
+enum SeekMode { SeekSet = 0, SeekCur = 1, SeekEnd = 2 };
+
+class File {
+public:
+    File() {}
+
+    explicit operator bool() const { return (bool)impl; }
+    size_t write(const uint8_t* buffer, size_t size);
+    size_t read(uint8_t* buffer, size_t size);
+    bool seek(uint32_t position, SeekMode mode = SeekSet);
+    size_t position() const;
+    size_t size() const;
+    int available();
+    void flush();
+    void close() { impl.reset(); }
+
+    const char* name() const;
+    const char* path() const;
+    bool isDirectory() const;
+    File openNextFile(const char* mode = "r");
+
+    struct Impl;
+    explicit File(std::shared_ptr<Impl> impl) : impl(impl) {}
+
+private:
+    std::shared_ptr<Impl> impl;
+};
+
+namespace fs {
+
+class FS {
+public:
+    File open(const char* path, const char* mode = "r", const bool create = false);
+    bool exists(const char* path);
+    bool remove(const char* path);
+    bool mkdir(const char* path);
+    bool rename(const char* from, const char* to);
+
+protected:
+    String hostPath(const char* path);
+    String root;
+};
+
+}
@@ -0,0 +1,52 @@
+/*
+ * Host Preferences shim: NVS namespaces held in memory for the process lifetime
+ */
+#pragma once
+
+#include "Arduino.h"
+#include <map>
+#include <mutex>
+#include <string>
+
+class Preferences {
+public:
+    // Read-only opens fail for a namespace never written, as on the device
+    bool begin(const char* name, bool readOnly = false) {
+        std::lock_guard<std::mutex> lock(storeMutex());
+        if(readOnly && store().find(name) == store().end()) return false;
+        space = &store()[name];
+        this->readOnly = readOnly;
+        return true;
+    }
+
+    void end() { space = NULL; }
+
+    int16_t getShort(const char* key, int16_t defaultValue = 0) {
+        std::lock_guard<std::mutex> lock(storeMutex());
+        if(!space) return defaultValue;
+        auto found = space->find(key);
+        return found == space->end() ? defaultValue : (int16_t)found->second;
+    }
+
+    size_t putShort(const char* key, int16_t value) {
+        std::lock_guard<std::mutex> lock(storeMutex());
+        if(!space || readOnly) return 0;
+        (*space)[key] = value;
+        return sizeof(value);
+    }
+
+private:
+    typedef std::map<std::string, long> Namespace;
+
+    static std::map<std::string, Namespace>& store() {
+        static std::map<std::string, Namespace> namespaces;
+        return namespaces;
+    }
+    static std::mutex& storeMutex() {
+        static std::mutex mutex;
+        return mutex;
+    }
+
+    Namespace* space = NULL;
+    bool readOnly = false;
+};
@@ -0,0 +1,305 @@
+/*
+ * Host WebServer shim: one connection per handleClient(), Connection: close
+ */
+#include "WebServer.h"
+
+#include <cctype>
+#include <cerrno>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define HTTP_MAX_HEADER_SIZE 8192
+#define HTTP_MAX_BODY_SIZE 65536
+
+int hostHttpPort = 0;
+
+static const char* statusText(int code) {
+    switch(code) {
+        case 200: return "OK";
+        case 202: return "Accepted";
+        case 204: return "No Content";
+        case 206: return "Partial Content";
+        case 304: return "Not Modified";
+        case 400: return "Bad Request";
+        case 404: return "Not Found";
+        case 409: return "Conflict";
+        case 416: return "Range Not Satisfiable";
+        case 500: return "Internal Server Error";
+        case 503: return "Service Unavailable";
+        default: return "";
+    }
+}
+
+static HTTPMethod parseMethod(const std::string& name) {
+    if(name == "GET") return HTTP_GET;
+    if(name == "HEAD") return HTTP_HEAD;
+    if(name == "POST") return HTTP_POST;
+    if(name == "PUT") return HTTP_PUT;
+    if(name == "PATCH") return HTTP_PATCH;
+    if(name == "DELETE") return HTTP_DELETE;
+    if(name == "OPTIONS") return HTTP_OPTIONS;
+    return HTTP_ANY;
+}
+
+static String urlDecode(const char* text, size_t length) {
+    std::string decoded;
+    for(size_t i = 0; i < length; i++) {
+        if(text[i] == '+') {
+            decoded += ' ';
+        } else if(text[i] == '%' && i + 2 < length && isxdigit((unsigned char)text[i + 1]) && isxdigit((unsigned char)text[i + 2])) {
+            char hex[3] = {text[i + 1], text[i + 2], 0};
+            decoded += (char)strtol(hex, NULL, 16);
+            i += 2;
+        } else {
+            decoded += text[i];
+        }
+    }
+    return String(decoded);
+}
+
+WebServer::~WebServer() {
+    if(listenFd >= 0) close(listenFd);
+}
+
+void WebServer::begin() {
+    int listenPort = hostHttpPort ? hostHttpPort : port;
+    listenFd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+
+    int yes = 1;
+    setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(listenPort);
+
+    if(bind(listenFd, (sockaddr*)&address, sizeof(address)) < 0 || listen(listenFd, 64) < 0) {
+        fprintf(stderr, "WebServer: cannot listen on port %d: %s\n", listenPort, strerror(errno));
+        exit(1);
+    }
+    fcntl(listenFd, F_SETFL, fcntl(listenFd, F_GETFL) | O_NONBLOCK);
+}
+
+void WebServer::on(const Uri& uri, HTTPMethod method, THandlerFunction handler) {
+    routes.push_back(Route{std::unique_ptr<Uri>(uri.clone()), method, handler});
+}
+
+void WebServer::collectHeaders(const char* headerKeys[], const size_t headerKeysCount) {
+    collectedHeaderKeys.clear();
+    for(size_t i = 0; i < headerKeysCount; i++) {
+        collectedHeaderKeys.push_back(headerKeys[i]);
+    }
+}
+
+void WebServer::handleClient() {
+    if(listenFd < 0) return;
+
+    int fd = accept4(listenFd, NULL, NULL, SOCK_CLOEXEC);
+    if(fd < 0) return;
+
+    timeval receiveTimeout = {HTTP_MAX_DATA_WAIT / 1000, (HTTP_MAX_DATA_WAIT % 1000) * 1000};
+    timeval sendTimeout = {HTTP_MAX_SEND_WAIT / 1000, (HTTP_MAX_SEND_WAIT % 1000) * 1000};
+    int yes = 1;
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &receiveTimeout, sizeof(receiveTimeout));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &sendTimeout, sizeof(sendTimeout));
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+    currentClient = WiFiClient(fd);
+
+    if(readRequest()) {
+        bool handled = false;
+        for(Route& route : routes) {
+            pathArgs.clear();
+            if((route.method == HTTP_ANY || route.method == requestMethod) &&
+               route.uri->canHandle(requestUri, pathArgs)) {
+                route.handler();
+                handled = true;
+                break;
+            }
+        }
+        if(!handled) {
+            send(404, "text/plain", String("Not found: ") + requestUri);
+        }
+        finalizeResponse();
+    }
+
+    currentClient.stop();
+    args.clear();
+    headers.clear();
+    pathArgs.clear();
+    responseHeaders = String();
+    pendingContentLength = CONTENT_LENGTH_NOT_SET;
+}
+
+bool WebServer::readRequest() {
+    std::string request;
+    size_t headerEnd;
+    char buffer[1024];
+
+    while((headerEnd = request.find("\r\n\r\n")) == std::string::npos) {
+        if(request.size() > HTTP_MAX_HEADER_SIZE) return false;
+        ssize_t got = recv(currentClient.fd(), buffer, sizeof(buffer), 0);
+        if(got <= 0) return false;
+        request.append(buffer, got);
+    }
+
+    // Request line: METHOD target version
+    size_t lineEnd = request.find("\r\n");
+    size_t methodEnd = request.find(' ');
+    size_t targetEnd = request.find(' ', methodEnd + 1);
+    if(methodEnd == std::string::npos || targetEnd == std::string::npos || targetEnd > lineEnd) return false;
+
+    requestMethod = parseMethod(request.substr(0, methodEnd));
+    std::string target = request.substr(methodEnd + 1, targetEnd - methodEnd - 1);
+    size_t query = target.find('?');
+    requestUri = String(target.substr(0, query));
+    if(query != std::string::npos) {
+        parseArgs(target.c_str() + query + 1, target.size() - query - 1);
+    }
+
+    // Headers; only the collected ones are kept, as on the device
+    size_t contentLength = 0;
+    bool formBody = false;
+    for(size_t pos = lineEnd + 2; pos < headerEnd; ) {
+        size_t end = request.find("\r\n", pos);
+        size_t colon = request.find(':', pos);
+        if(colon != std::string::npos && colon < end) {
+            String name(request.substr(pos, colon - pos));
+            size_t valueStart = request.find_first_not_of(' ', colon + 1);
+            String value(valueStart < end ? request.substr(valueStart, end - valueStart) : std::string());
+
+            if(name.equalsIgnoreCase("Content-Length")) contentLength = strtoul(value.c_str(), NULL, 10);
+            if(name.equalsIgnoreCase("Content-Type")) formBody = strstr(value.c_str(), "application/x-www-form-urlencoded") != NULL;
+            for(const String& key : collectedHeaderKeys) {
+                if(name.equalsIgnoreCase(key)) headers.push_back(Pair{key, value});
+            }
+        }
+        pos = end + 2;
+    }
+
+    if(contentLength > HTTP_MAX_BODY_SIZE) return false;
+    std::string body = request.substr(headerEnd + 4);
+    while(body.size() < contentLength) {
+        ssize_t got = recv(currentClient.fd(), buffer, min(sizeof(buffer), contentLength - body.size()), 0);
+        if(got <= 0) return false;
+        body.append(buffer, got);
+    }
+    if(contentLength > 0) {
+        if(formBody) parseArgs(body.c_str(), contentLength);
+        else args.push_back(Pair{"plain", String(body.substr(0, contentLength))});
+    }
+
+    return true;
+}
+
+void WebServer::parseArgs(const char* query, size_t length) {
+    const char* end = query + length;
+    while(query < end) {
+        const char* separator = (const char*)memchr(query, '&', end - query);
+        if(!separator) separator = end;
+        const char* equals = (const char*)memchr(query, '=', separator - query);
+        if(separator > query) {
+            if(equals) {
+                args.push_back(Pair{urlDecode(query, equals - query), urlDecode(equals + 1, separator - equals - 1)});
+            } else {
+                args.push_back(Pair{urlDecode(query, separator - query), String()});
+            }
+        }
+        query = separator + 1;
+    }
+}
+
+String WebServer::arg(const String& name) {
+    for(const Pair& pair : args) {
+        if(pair.name == name) return pair.value;
+    }
+    return String();
+}
+
+bool WebServer::hasArg(const String& name) {
+    for(const Pair& pair : args) {
+        if(pair.name == name) return true;
+    }
+    return false;
+}
+
+String WebServer::pathArg(unsigned int index) {
+    return index < pathArgs.size() ? pathArgs[index] : String();
+}
+
+String WebServer::header(const String& name) {
+    for(const Pair& pair : headers) {
+        if(pair.name.equalsIgnoreCase(name)) return pair.value;
+    }
+    return String();
+}
+
+bool WebServer::hasHeader(const String& name) {
+    for(const Pair& pair : headers) {
+        if(pair.name.equalsIgnoreCase(name)) return true;
+    }
+    return false;
+}
+
+void WebServer::sendHeader(const String& name, const String& value, bool first) {
+    String line = name + ": " + value + "\r\n";
+    responseHeaders = first ? line + responseHeaders : responseHeaders + line;
+}
+
+void WebServer::sendHeaders(int code, const char* contentType, size_t contentLength) {
+    char line[64];
+    snprintf(line, sizeof(line), "HTTP/1.1 %d %s\r\n", code, statusText(code));
+    String head(line);
+
+    if(contentType) head = head + "Content-Type: " + contentType + "\r\n";
+
+    if(pendingContentLength == CONTENT_LENGTH_UNKNOWN) {
+        chunked = true;
+        head += "Transfer-Encoding: chunked\r\n";
+    } else {
+        size_t length = pendingContentLength == CONTENT_LENGTH_NOT_SET ? contentLength : pendingContentLength;
+        snprintf(line, sizeof(line), "Content-Length: %zu\r\n", length);
+        head += line;
+    }
+    head += "Connection: close\r\n";
+    head += responseHeaders;
+    head += "\r\n";
+
+    currentClient.write(head.c_str(), head.length());
+    responseHeaders = String();
+    pendingContentLength = CONTENT_LENGTH_NOT_SET;
+}
+
+void WebServer::send(int code, const char* contentType, const String& content) {
+    sendHeaders(code, contentType, content.length());
+    if(content.length() > 0) sendContent(content);
+}
+
+void WebServer::send_P(int code, PGM_P contentType, PGM_P content, size_t contentLength) {
+    sendHeaders(code, contentType, contentLength);
+    if(contentLength > 0) sendContent(content, contentLength);
+}
+
+void WebServer::sendContent(const char* content, size_t size) {
+    if(size == 0) return;
+    if(chunked) {
+        char header[16];
+        int length = snprintf(header, sizeof(header), "%zx\r\n", size);
+        currentClient.write(header, length);
+        currentClient.write(content, size);
+        currentClient.write("\r\n", 2);
+    } else {
+        currentClient.write(content, size);
+    }
+}
+
+// Terminate a chunked body; a handler that took over the socket has stopped it
+void WebServer::finalizeResponse() {
+    if(chunked && currentClient) {
+        currentClient.write("0\r\n\r\n", 5);
+    }
+    chunked = false;
+}
@@ -0,0 +1,109 @@
+/*
+ * Host WebServer shim
+ *
+ * A POSIX-socket implementation of the subset of the ESP32 WebServer API
+ * the firmware uses, with the same request model: handleClient() accepts at
+ * most one connection per call, reads the request, runs the matching
+ * handler and closes the connection. Responses are framed the same way
+ * (Content-Length, or chunked for CONTENT_LENGTH_UNKNOWN), so handlers run
+ * unchanged and their cost can be measured on a workstation.
+ */
+#pragma once
+
+#include "Arduino.h"
+#include "WiFi.h"
+#include <functional>
+#include <memory>
+#include <vector>
+
+#define CONTENT_LENGTH_UNKNOWN ((size_t)-1)
+#define CONTENT_LENGTH_NOT_SET ((size_t)-2)
+#define HTTP_MAX_DATA_WAIT 5000     // ms to wait for the request to arrive
+#define HTTP_MAX_SEND_WAIT 5000     // ms to wait for the client to drain a send
+
+enum HTTPMethod { HTTP_ANY, HTTP_GET, HTTP_HEAD, HTTP_POST, HTTP_PUT, HTTP_PATCH, HTTP_DELETE, HTTP_OPTIONS };
+
+// Port used instead of the one given to the constructor (0 = keep it)
+extern int hostHttpPort;
+
+class Uri {
+public:
+    Uri(const char* uri) : uri(uri) {}
+    Uri(const String& uri) : uri(uri) {}
+    virtual ~Uri() {}
+
+    virtual Uri* clone() const { return new Uri(uri); }
+    virtual bool canHandle(const String& requestUri, std::vector<String>& pathArgs) {
+        (void)pathArgs;
+        return requestUri == uri;
+    }
+
+protected:
+    String uri;
+};
+
+class WebServer {
+public:
+    typedef std::function<void(void)> THandlerFunction;
+
+    explicit WebServer(int port = 80) : port(port) {}
+    ~WebServer();
+
+    void begin();
+    void handleClient();
+    void enableDelay(bool value) { (void)value; }     // handleClient() never sleeps here
+
+    void on(const Uri& uri, THandlerFunction handler) { on(uri, HTTP_ANY, handler); }
+    void on(const Uri& uri, HTTPMethod method, THandlerFunction handler);
+    void collectHeaders(const char* headerKeys[], const size_t headerKeysCount);
+
+    HTTPMethod method() { return requestMethod; }
+    String uri() { return requestUri; }
+    WiFiClient& client() { return currentClient; }
+
+    String arg(const String& name);
+    bool hasArg(const String& name);
+    String pathArg(unsigned int index);
+    String header(const String& name);
+    bool hasHeader(const String& name);
+
+    void send(int code, const char* contentType = NULL, const String& content = String(""));
+    void send(int code, const char* contentType, const char* content) { send(code, contentType, String(content)); }
+    void send_P(int code, PGM_P contentType, PGM_P content, size_t contentLength);
+    void sendHeader(const String& name, const String& value, bool first = false);
+    void setContentLength(const size_t length) { pendingContentLength = length; }
+    void sendContent(const char* content, size_t size);
+    void sendContent(const String& content) { sendContent(content.c_str(), content.length()); }
+
+private:
+    struct Route {
+        std::unique_ptr<Uri> uri;
+        HTTPMethod method;
+        THandlerFunction handler;
+    };
+    struct Pair {
+        String name;
+        String value;
+    };
+
+    bool readRequest();
+    void parseArgs(const char* query, size_t length);
+    void sendHeaders(int code, const char* contentType, size_t contentLength);
+    void finalizeResponse();
+
+    int port;
+    int listenFd = -1;
+    std::vector<Route> routes;
+    std::vector<String> collectedHeaderKeys;
+
+    WiFiClient currentClient;
+    HTTPMethod requestMethod = HTTP_GET;
+    String requestUri;
+    std::vector<Pair> args;
+    std::vector<Pair> headers;
+    std::vector<String> pathArgs;
+
+    String responseHeaders;
+    size_t pendingContentLength = CONTENT_LENGTH_NOT_SET;
+    bool chunked = false;
+};
@@ -0,0 +1,46 @@
+/*
+ * Host WiFi shim: loopback "access point" and socket-backed clients
+ */
+#include "WiFi.h"
+
+#include <cerrno>
+#include <sys/socket.h>
+#include <unistd.h>
+
+WiFiClass WiFi;
+
+String IPAddress::toString() const {
+    char text[16];
+    snprintf(text, sizeof(text), "%u.%u.%u.%u", octets[0], octets[1], octets[2], octets[3]);
+    return String(text);
+}
+
+WiFiClient::WiFiClient(int fd) : socket(new Socket{fd}) {}
+
+WiFiClient::Socket::~Socket() {
+    close(fd);
+}
+
+bool WiFiClient::connected() {
+    if(!socket) return false;
+    char probe;
+    int result = recv(socket->fd, &probe, 1, MSG_PEEK | MSG_DONTWAIT);
+    if(result > 0) return true;
+    if(result < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return true;
+    return false;
+}
+
+// Blocking write of the whole buffer, bounded by the socket send timeout
+size_t WiFiClient::write(const uint8_t* buffer, size_t size) {
+    size_t written = 0;
+    while(socket && written < size) {
+        ssize_t sent = send(socket->fd, buffer + written, size - written, MSG_NOSIGNAL);
+        if(sent < 0) {
+            // EAGAIN here means the send timeout expired; give up like the core
+            if(errno == EINTR) continue;
+            break;
+        }
+        written += sent;
+    }
+    return written;
+}
@@ -0,0 +1,54 @@
+/*
+ * Host WiFi shim
+ *
+ * The soft AP is the loopback interface. WiFiClient wraps a connected
+ * socket shared between copies, closed when the last copy lets go, as in
+ * the ESP32 core; the SSE handler relies on that to keep a client open.
+ */
+#pragma once
+
+#include "Arduino.h"
+#include <memory>
+
+#define WIFI_AP 2
+
+class IPAddress : public Printable {
+public:
+    IPAddress(uint8_t a = 0, uint8_t b = 0, uint8_t c = 0, uint8_t d = 0) : octets{a, b, c, d} {}
+    String toString() const;
+    size_t printTo(Print& p) const override { return p.print(toString()); }
+
+private:
+    uint8_t octets[4];
+};
+
+class WiFiClass {
+public:
+    bool mode(int mode) { (void)mode; return true; }
+    bool softAP(const char* ssid, const char* password) { (void)ssid; (void)password; return true; }
+    IPAddress softAPIP() { return IPAddress(127, 0, 0, 1); }
+    uint8_t softAPgetStationNum() { return 0; }
+};
+
+extern WiFiClass WiFi;
+
+class WiFiClient : public Print {
+public:
+    WiFiClient() {}
+    explicit WiFiClient(int fd);
+
+    int fd() const { return socket ? socket->fd : -1; }
+    bool connected();
+    void stop() { socket.reset(); }
+    explicit operator bool() const { return (bool)socket; }
+
+    size_t write(const uint8_t* buffer, size_t size) override;
+    using Print::write;
+
+private:
+    struct Socket {
+        int fd;
+        ~Socket();
+    };
+    std::shared_ptr<Socket> socket;
+};
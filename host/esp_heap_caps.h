@@ -0,0 +1,27 @@
+/*
+ * Host heap_caps shim: malloc arena statistics stand in for the ESP32 heap
+ */
+#pragma once
+
+#include <malloc.h>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+
+#define MALLOC_CAP_8BIT (1 << 2)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+
+inline void* heap_caps_malloc(size_t size, uint32_t caps) {
+    (void)caps;
+    return malloc(size);
+}
+
+inline void heap_caps_free(void* ptr) {
+    free(ptr);
+}
+
+// glibc does not report fragmentation; free arena bytes are the upper bound
+inline size_t heap_caps_get_largest_free_block(uint32_t caps) {
+    (void)caps;
+    return mallinfo2().fordblks;
+}
@@ -0,0 +1,19 @@
+/*
+ * Host esp_vfs_eventfd shim: eventfd is native, registration is a no-op
+ */
+#pragma once
+
+#include <sys/eventfd.h>
+
+typedef int esp_err_t;
+
+typedef struct {
+    size_t max_fds;
+} esp_vfs_eventfd_config_t;
+
+#define ESP_VFS_EVENTD_CONFIG_DEFAULT() { 5 }
+
+inline esp_err_t esp_vfs_eventfd_register(const esp_vfs_eventfd_config_t* config) {
+    (void)config;
+    return 0;
+}
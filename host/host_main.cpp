@@ -0,0 +1,119 @@
+/*
+ * Host entry point: runs the firmware's setup() and loop() on Linux
+ *
+ * Usage: firmware-host [--port N] [--loopback OUT:IN[:inverted][:SKEW]]...
+ *                      [--pattern PIN:T1,T2,...]... [--pattern-repeat MS:N]
+ *                      [--inputs scheduled|real]
+ *
+ * --port N      listen on N (default 8080; LITTLEFS_ROOT sets the directory
+ *               backing the flash file system)
+ * --loopback    wire a send pin to a receive pin, as on a self-test bench;
+ *               IR receivers are active low, so use 4:15:inverted and 12:14.
+ *               SKEW (us) lengthens every mark the receiver sees and
+ *               shortens every space, e.g. 4:15:inverted:40
+ * --inputs      scheduled (default): inputs change at their due time, so
+ *               captures are exact; real: when the driving thread runs
+ * --pattern     play timings (us, starting with the active LOW level) on an
+ *               input pin, standing in for a remote
+ * --pattern-repeat
+ *               play the patterns every MS milliseconds, N times or, with
+ *               N = 0, until exit (default 250:10)
+ */
+#include "Arduino.h"
+#include "WebServer.h"
+
+#include <chrono>
+#include <csignal>
+#include <sys/prctl.h>
+#include <thread>
+#include <vector>
+
+#define PATTERN_START_MS 500        // After boot
+
+struct Pattern {
+    uint8_t pin;
+    std::vector<uint32_t> timings;
+};
+
+static unsigned long patternPeriodMs = 250;
+static unsigned long patternRepeats = 10;   // 0 = until exit
+
+void setup();
+void loop();
+
+static void usage(const char* name) {
+    fprintf(stderr, "usage: %s [--port N] [--loopback OUT:IN[:inverted][:SKEW]]... [--pattern PIN:T1,T2,...]... "
+                    "[--pattern-repeat MS:N] [--inputs scheduled|real]\n", name);
+    exit(2);
+}
+
+static void playPattern(Pattern pattern) {
+    using namespace std::chrono;
+    prctl(PR_SET_TIMERSLACK, 1000UL);
+    steady_clock::time_point start = steady_clock::now() + milliseconds(PATTERN_START_MS);
+    for(unsigned long repeat = 0; !patternRepeats || repeat < patternRepeats; repeat++) {
+        steady_clock::time_point edge = start + milliseconds(repeat * patternPeriodMs);
+        std::this_thread::sleep_until(edge);
+        for(size_t i = 0; i < pattern.timings.size(); i++) {
+            hostSetPinLevel(pattern.pin, i % 2 ? HIGH : LOW, hostMicrosAt(edge));
+            edge += microseconds(pattern.timings[i]);
+            std::this_thread::sleep_until(edge);
+        }
+        hostSetPinLevel(pattern.pin, HIGH, hostMicrosAt(edge));
+    }
+}
+
+int main(int argc, char** argv) {
+    hostHttpPort = 8080;
+    std::vector<Pattern> patterns;
+    for(int i = 1; i < argc; i++) {
+        if(i + 1 >= argc) usage(argv[0]);
+        const char* value = argv[i + 1];
+        char* end;
+        if(strcmp(argv[i], "--port") == 0) {
+            hostHttpPort = atoi(value);
+        } else if(strcmp(argv[i], "--loopback") == 0) {
+            unsigned long output = strtoul(value, &end, 10);
+            if(*end != ':') usage(argv[0]);
+            unsigned long input = strtoul(end + 1, &end, 10);
+            bool inverted = strncmp(end, ":inverted", 9) == 0;
+            if(inverted) end += 9;
+            long skew = 0;
+            if(*end == ':') skew = strtol(end + 1, &end, 10);
+            if(*end) usage(argv[0]);
+            hostLoopback(output, input, inverted, skew);
+        } else if(strcmp(argv[i], "--pattern") == 0) {
+            Pattern pattern;
+            pattern.pin = strtoul(value, &end, 10);
+            if(*end != ':') usage(argv[0]);
+            do {
+                pattern.timings.push_back(strtoul(end + 1, &end, 10));
+            } while(*end == ',');
+            if(*end) usage(argv[0]);
+            patterns.push_back(pattern);
+        } else if(strcmp(argv[i], "--pattern-repeat") == 0) {
+            patternPeriodMs = strtoul(value, &end, 10);
+            if(*end != ':') usage(argv[0]);
+            patternRepeats = strtoul(end + 1, &end, 10);
+            if(*end || !patternPeriodMs) usage(argv[0]);
+        } else if(strcmp(argv[i], "--inputs") == 0) {
+            if(strcmp(value, "real") != 0 && strcmp(value, "scheduled") != 0) usage(argv[0]);
+            hostRealTimeInputs = strcmp(value, "real") == 0;
+        } else {
+            usage(argv[0]);
+        }
+        i++;
+    }
+    for(const Pattern& pattern : patterns) {
+        std::thread(playPattern, pattern).detach();
+    }
+
+    // SSE clients write with send(); a vanished peer must not kill the process
+    signal(SIGPIPE, SIG_IGN);
+    setvbuf(stdout, NULL, _IOLBF, 0);
+
+    setup();
+    for(;;) {
+        loop();
+    }
+}
@@ -0,0 +1,193 @@
+/*
+ * Capture jitter harness for the host build
+ *
+ * Runs RF captures (POST /api/capture?type=RF) against a firmware-host
+ * that plays a burst of 600/1200 us pulses into the RF receiver, fetches
+ * each captured signal's timings and compares every timing with the
+ * nearest nominal width. The first timing of a capture is dropped: it
+ * runs from the start of the capture, not from an edge. A timing over
+ * MERGED_US means an edge was missed and is counted, not graded.
+ *
+ * Prints one row once COUNT timings have been collected, or after
+ * MAX_CAPTURES attempts: the label, the timings graded and merged, the
+ * standard deviation, p99 and maximum of the error, and the captures that
+ * failed (no burst within the capture timeout, or too few edges kept).
+ * A row short of COUNT timings is still printed, but the exit status is 1.
+ *
+ * Usage: jitter [-H host] [-p port] [-n count] [label]
+ */
+#include <algorithm>
+#include <arpa/inet.h>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#define SHORT_US 600
+#define LONG_US 1200
+#define MERGED_US 1800
+#define MAX_CAPTURES 200        // Attempts per row
+#define JOB_POLL_MS 20
+
+static sockaddr_in target;
+static const char* hostName = "127.0.0.1";
+
+// One request on a fresh connection; returns the HTTP status (0 on
+// failure) and the de-chunked body
+static int request(const char* method, const std::string& path, std::string& body) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if(fd < 0) return 0;
+
+    int yes = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+    timeval timeout = {10, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    std::string head = std::string(method) + " " + path + " HTTP/1.1\r\nHost: " + hostName +
+                       "\r\nConnection: close\r\nContent-Length: 0\r\n\r\n";
+    std::string response;
+    if(connect(fd, (sockaddr*)&target, sizeof(target)) == 0 &&
+       send(fd, head.data(), head.size(), MSG_NOSIGNAL) == (ssize_t)head.size()) {
+        char buffer[4096];
+        ssize_t got;
+        while((got = recv(fd, buffer, sizeof(buffer), 0)) > 0) {
+            response.append(buffer, got);
+        }
+    }
+    close(fd);
+
+    size_t split = response.find("\r\n\r\n");
+    if(split == std::string::npos || response.compare(0, 7, "HTTP/1.") != 0) return 0;
+    body = response.substr(split + 4);
+
+    if(response.find("Transfer-Encoding: chunked") < split) {
+        std::string joined;
+        size_t at = 0;
+        for(;;) {
+            size_t length = strtoul(body.c_str() + at, NULL, 16);
+            at = body.find("\r\n", at);
+            if(!length || at == std::string::npos) break;
+            joined += body.substr(at + 2, length);
+            at += 2 + length + 2;
+        }
+        body = joined;
+    }
+    return atoi(response.c_str() + 9);
+}
+
+// Value of a JSON string or number field, empty if absent
+static std::string field(const std::string& json, const char* name) {
+    std::string key = std::string("\"") + name + "\":";
+    size_t at = json.find(key);
+    if(at == std::string::npos) return "";
+    at += key.size();
+    if(json[at] == '"') return json.substr(at + 1, json.find('"', at + 1) - at - 1);
+    return json.substr(at, json.find_first_of(",}", at) - at);
+}
+
+// One capture; appends its timings after the first. Returns NULL, or
+// what went wrong.
+static const char* capture(std::vector<uint16_t>& timings) {
+    std::string body;
+    if(request("POST", "/api/capture?type=RF", body) != 202) return "capture not accepted";
+    std::string job = field(body, "job");
+
+    std::string status;
+    do {
+        std::this_thread::sleep_for(std::chrono::milliseconds(JOB_POLL_MS));
+        if(request("GET", "/api/jobs/" + job, body) != 200) return "job lost";
+        status = field(body, "status");
+    } while(status == "queued" || status == "running");
+    if(status != "done") return "capture failed";
+
+    if(request("GET", "/api/signal/" + field(body, "signal") + "/timings", body) != 200) return "signal gone";
+    for(size_t i = 1; i < body.size() / 2; i++) {
+        timings.push_back((uint8_t)body[2 * i] | (uint8_t)body[2 * i + 1] << 8);
+    }
+    return NULL;
+}
+
+static void usage(const char* name) {
+    fprintf(stderr, "usage: %s [-H host] [-p port] [-n count] [label]\n", name);
+    exit(2);
+}
+
+int main(int argc, char** argv) {
+    int port = 8080;
+    size_t count = 1000;
+
+    int arg = 1;
+    for(; arg < argc && argv[arg][0] == '-' && argv[arg][1]; arg++) {
+        if(arg + 1 >= argc) usage(argv[0]);
+        char option = argv[arg][1];
+        const char* value = argv[++arg];
+        if(option == 'H') hostName = value;
+        else if(option == 'p') port = atoi(value);
+        else if(option == 'n') count = std::max(atol(value), 1L);
+        else usage(argv[0]);
+    }
+    if(arg + 1 < argc) usage(argv[0]);
+    const char* label = arg < argc ? argv[arg] : "";
+
+    target.sin_family = AF_INET;
+    target.sin_port = htons(port);
+    if(inet_pton(AF_INET, hostName, &target.sin_addr) != 1) {
+        fprintf(stderr, "jitter: host must be an IPv4 address\n");
+        return 2;
+    }
+
+    std::vector<uint16_t> timings;
+    size_t failed = 0;
+    const char* lastError = NULL;
+    for(int i = 0; i < MAX_CAPTURES && timings.size() < count; i++) {
+        const char* error = capture(timings);
+        if(error) {
+            failed++;
+            lastError = error;
+        }
+    }
+    bool complete = timings.size() >= count;
+    if(complete) timings.resize(count);
+
+    std::vector<double> errors;
+    size_t merged = 0;
+    for(uint16_t timing : timings) {
+        if(timing > MERGED_US) {
+            merged++;
+            continue;
+        }
+        int nominal = abs(timing - SHORT_US) < abs(timing - LONG_US) ? SHORT_US : LONG_US;
+        errors.push_back(timing - nominal);
+    }
+
+    double sum = 0, squares = 0;
+    for(double error : errors) sum += error;
+    double mean = errors.empty() ? 0 : sum / errors.size();
+    for(double error : errors) squares += (error - mean) * (error - mean);
+    double sd = errors.size() > 1 ? sqrt(squares / (errors.size() - 1)) : 0;
+
+    std::vector<double> magnitudes;
+    for(double error : errors) magnitudes.push_back(fabs(error));
+    std::sort(magnitudes.begin(), magnitudes.end());
+    double p99 = 0;
+    if(!magnitudes.empty()) {
+        size_t rank = (size_t)(0.99 * magnitudes.size() + 0.999999);
+        p99 = magnitudes[std::min(std::max(rank, (size_t)1), magnitudes.size()) - 1];
+    }
+
+    printf("%-16s %7zu %7zu %8.0f %8.0f %8.0f %7zu\n", label, errors.size(), merged, sd, p99,
+           magnitudes.empty() ? 0.0 : magnitudes.back(), failed);
+    if(!complete) {
+        fprintf(stderr, "jitter: %zu of %zu timings in %d captures (last failure: %s)\n",
+                timings.size(), count, MAX_CAPTURES, lastError ? lastError : "none");
+    }
+    return complete ? 0 : 1;
+}
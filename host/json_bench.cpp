@@ -0,0 +1,191 @@
+/*
+ * Response allocation benchmark for the host build
+ *
+ * Fills the signal store and the activity log, then calls the /api/status,
+ * /api/signals and /api/log handlers in-process, each next to a copy built
+ * the way the firmware used to: one String grown with json += String(...)
+ * and sent in one piece. malloc, calloc and realloc are counted around
+ * every call, so each row shows the heap allocations and microseconds per
+ * response. The shim's own header framing is allocated the same way for
+ * both variants and is shown on its own row. Both /api/status variants
+ * send its ETag and Cache-Control headers.
+ *
+ * The shim's String is std::string with small-string optimization, which
+ * spares the String side short temporaries an ESP32 String would
+ * allocate, so its counts are a lower bound.
+ *
+ * Usage: json_bench [-n iterations]
+ */
+#include "../main.cpp"
+
+#include <chrono>
+
+extern "C" void* __libc_malloc(size_t size);
+extern "C" void* __libc_calloc(size_t count, size_t size);
+extern "C" void* __libc_realloc(void* pointer, size_t size);
+
+static bool counting = false;
+static unsigned long allocations = 0;
+static unsigned long allocatedBytes = 0;
+
+extern "C" void* malloc(size_t size) {
+    if(counting) {
+        allocations++;
+        allocatedBytes += size;
+    }
+    return __libc_malloc(size);
+}
+
+extern "C" void* calloc(size_t count, size_t size) {
+    if(counting) {
+        allocations++;
+        allocatedBytes += count * size;
+    }
+    return __libc_calloc(count, size);
+}
+
+extern "C" void* realloc(void* pointer, size_t size) {
+    if(counting) {
+        allocations++;
+        allocatedBytes += size;
+    }
+    return __libc_realloc(pointer, size);
+}
+
+// Revalidation as in handleStatus(), so the two differ only in the body
+static void legacyStatus() {
+    uint32_t revision = statusRevision.load(std::memory_order_relaxed);
+    char etag[16];
+    snprintf(etag, sizeof(etag), "\"r%lu\"", (unsigned long)revision);
+
+    uint32_t since = 0;
+    if(server.hasArg("since")) since = strtoul(server.arg("since").c_str(), NULL, 10);
+    server.sendHeader("ETag", etag);
+    server.sendHeader("Cache-Control", "no-cache");
+    if(since == revision) {
+        server.send(304);
+        return;
+    }
+
+    SignalStoreMeta meta;
+    readStoreMeta(meta);
+
+    String json = "{";
+    json += "\"revision\":" + String((unsigned long)revision) + ",";
+    json += "\"state\":\"" + String(activityName()) + "\",";
+    json += "\"signalCount\":" + String((unsigned long)signalCounter.load()) + ",";
+    json += "\"signalsRevision\":" + String((unsigned long)signalsRevision.load()) + ",";
+    json += "\"stored\":" + String((unsigned int)meta.byTime.count) + ",";
+    json += "\"storedIR\":" + String((unsigned int)meta.byType[SIGNAL_TYPE_IR].count) + ",";
+    json += "\"storedRF\":" + String((unsigned int)meta.byType[SIGNAL_TYPE_RF].count) + ",";
+    json += "\"logDropped\":" + String((unsigned long)activityLogDropped.load()) + ",";
+    json += "\"logHead\":" + String((unsigned long)(logSequenceBase + activityLogHead.load()));
+    json += "}";
+
+    server.send(200, "application/json", json);
+}
+
+static void legacySignals() {
+    uint32_t revision = signalsRevision.load(std::memory_order_acquire);
+    SignalSummary page[SIGNAL_PAGE_MAX];
+    size_t count;
+    size_t total = querySignals(-1, 0, ULONG_MAX, true, 0, 20, page, count);
+
+    String json = "{";
+    json += "\"revision\":" + String((unsigned long)revision) + ",";
+    json += "\"total\":" + String((unsigned long)total) + ",";
+    json += "\"offset\":0,";
+    json += "\"signals\":[";
+    for(size_t i = 0; i < count; i++) {
+        if(i > 0) json += ",";
+        json += "{";
+        json += "\"id\":\"" + String(page[i].id) + "\",";
+        json += "\"number\":" + String((unsigned long)page[i].number) + ",";
+        json += "\"type\":\"" + String(page[i].type == SIGNAL_TYPE_IR ? "IR" : "RF") + "\",";
+        json += "\"length\":" + String((unsigned int)page[i].length) + ",";
+        json += "\"timestamp\":" + String(page[i].timestamp);
+        if(page[i].type == SIGNAL_TYPE_IR) {
+            json += ",\"carrierHz\":" + String((unsigned long)page[i].carrierHz);
+            json += ",\"carrierDuty\":" + String((unsigned int)page[i].carrierDuty);
+        }
+        json += "}";
+    }
+    json += "]}";
+
+    server.send(200, "application/json", json);
+}
+
+static void legacyLog() {
+    uint32_t head = activityLogHead.load(std::memory_order_acquire);
+    uint32_t end = logSequenceBase + head;
+    uint32_t from = end > MAX_LOG_ENTRIES ? end - MAX_LOG_ENTRIES : 0;
+
+    String json = "{\"last\":" + String((unsigned long)(end - 1)) + ",\"entries\":[";
+    for(uint32_t sequence = from; sequence < end; sequence++) {
+        ActivityLogEntry entry;
+        if(readActivityLogSlot(sequence - logSequenceBase, entry) != LOG_SLOT_READY) continue;
+        char message[64];
+        formatActivityLog(entry, message, sizeof(message));
+
+        if(sequence > from) json += ",";
+        json += "{\"seq\":" + String((unsigned long)sequence) + ",";
+        json += "\"timestamp\":" + String(entry.timestamp) + ",";
+        json += "\"message\":\"" + String(message) + "\"}";
+    }
+    json += "]}";
+
+    server.send(200, "application/json", json);
+}
+
+static void framingOnly() {
+    server.send(200, "application/json", "{}");
+}
+
+static void measure(const char* name, void (*handler)(), int iterations) {
+    handler();      // Warm up lazily built state
+
+    allocations = 0;
+    allocatedBytes = 0;
+    auto start = std::chrono::steady_clock::now();
+    counting = true;
+    for(int i = 0; i < iterations; i++) handler();
+    counting = false;
+    double elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+    printf("%-26s %8.1f allocs  %8.0f bytes  %7.2f us\n", name,
+           (double)allocations / iterations, (double)allocatedBytes / iterations, elapsed / iterations);
+}
+
+int main(int argc, char** argv) {
+    int iterations = 20000;
+    if(argc == 3 && strcmp(argv[1], "-n") == 0) iterations = atoi(argv[2]);
+
+    storeWriteMutex = xSemaphoreCreateMutex();
+    storeBegin();
+    jobsMutex = xSemaphoreCreateMutex();
+
+    // A full store, a third of it IR, and a log that has wrapped
+    static RawSignal signal;
+    for(int n = 0; n < MAX_STORED_SIGNALS; n++) {
+        signal.type = n % 3 == 0 ? SIGNAL_TYPE_IR : SIGNAL_TYPE_RF;
+        signal.number = generateSignalId(signal.id, sizeof(signal.id), signal.type);
+        signal.timestamp = 1000 + n * 250;
+        signal.length = 64;
+        signal.carrierHz = signal.type == SIGNAL_TYPE_IR ? IR_CARRIER_DEFAULT_HZ : 0;
+        signal.carrierDuty = signal.type == SIGNAL_TYPE_IR ? IR_CARRIER_DEFAULT_DUTY : 0;
+        storeSignal(signal);
+    }
+    for(int n = 0; n < LOG_RING_SLOTS; n++) {
+        LOG_EVENT(EVT_IR_CAPTURED, n, 64);
+    }
+
+    printf("%d responses each, %d stored signals\n", iterations, MAX_STORED_SIGNALS);
+    measure("header framing only", framingOnly, iterations);
+    measure("/api/status  String", legacyStatus, iterations);
+    measure("/api/status  JsonWriter", handleStatus, iterations);
+    measure("/api/signals String", legacySignals, iterations);
+    measure("/api/signals JsonWriter", handleSignals, iterations);
+    measure("/api/log     String", legacyLog, iterations);
+    measure("/api/log     JsonWriter", handleLog, iterations);
+    return 0;
+}
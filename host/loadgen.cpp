@@ -0,0 +1,181 @@
+/*
+ * HTTP load generator for the host build
+ *
+ * Opens one connection per request (the firmware answers Connection: close)
+ * from a fixed number of concurrent workers, each cycling through the given
+ * endpoints, and reports per endpoint the request rate and p50/p99/p999
+ * latency measured from connect() to the end of the response.
+ *
+ * Usage: loadgen [-H host] [-p port] [-c concurrency] [-d seconds | -n requests]
+ *                [[METHOD ]PATH ...]
+ * e.g.   loadgen -c 8 -d 10 / /api/status "POST /api/attack/stop"
+ */
+#include <algorithm>
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+struct Endpoint {
+    std::string method;
+    std::string path;
+    std::string request;
+};
+
+struct Sample {
+    uint32_t microseconds;
+    int status;     // 0 = connection or protocol failure
+};
+
+typedef std::chrono::steady_clock Clock;
+
+static sockaddr_in target;
+static std::vector<Endpoint> endpoints;
+static bool byCount;                    // -n given: stop after a request count
+static std::atomic<long> remaining;
+static Clock::time_point deadline;
+
+// One request on a fresh connection; returns the HTTP status or 0
+static int runRequest(const Endpoint& endpoint) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if(fd < 0) return 0;
+
+    int yes = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+    timeval timeout = {10, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    int status = 0;
+    if(connect(fd, (sockaddr*)&target, sizeof(target)) == 0 &&
+       send(fd, endpoint.request.data(), endpoint.request.size(), MSG_NOSIGNAL) == (ssize_t)endpoint.request.size()) {
+        char buffer[4096];
+        char head[16] = {0};
+        size_t headLength = 0;
+        ssize_t got;
+        while((got = recv(fd, buffer, sizeof(buffer), 0)) > 0) {
+            size_t copy = std::min((size_t)got, sizeof(head) - 1 - headLength);
+            memcpy(head + headLength, buffer, copy);
+            headLength += copy;
+        }
+        if(got == 0 && strncmp(head, "HTTP/1.", 7) == 0) {
+            status = atoi(head + 9);
+        }
+    }
+
+    close(fd);
+    return status;
+}
+
+static void worker(size_t first, std::vector<std::vector<Sample>>* samples) {
+    for(size_t i = first; ; i++) {
+        if(byCount ? remaining.fetch_sub(1) <= 0 : Clock::now() >= deadline) break;
+
+        size_t index = i % endpoints.size();
+        Clock::time_point start = Clock::now();
+        int status = runRequest(endpoints[index]);
+        uint32_t elapsed = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count();
+        (*samples)[index].push_back(Sample{elapsed, status});
+    }
+}
+
+static double percentile(const std::vector<uint32_t>& sorted, double fraction) {
+    if(sorted.empty()) return 0;
+    size_t rank = (size_t)(fraction * sorted.size() + 0.999999);
+    return sorted[std::min(std::max(rank, (size_t)1), sorted.size()) - 1] / 1000.0;
+}
+
+static void usage(const char* name) {
+    fprintf(stderr, "usage: %s [-H host] [-p port] [-c concurrency] [-d seconds | -n requests] [[METHOD ]PATH ...]\n", name);
+    exit(2);
+}
+
+int main(int argc, char** argv) {
+    const char* host = "127.0.0.1";
+    int port = 8080;
+    int concurrency = 4;
+    double seconds = 10;
+    long requests = -1;
+
+    int arg = 1;
+    for(; arg < argc && argv[arg][0] == '-' && argv[arg][1]; arg++) {
+        if(arg + 1 >= argc) usage(argv[0]);
+        char option = argv[arg][1];
+        const char* value = argv[++arg];
+        if(option == 'H') host = value;
+        else if(option == 'p') port = atoi(value);
+        else if(option == 'c') concurrency = std::max(atoi(value), 1);
+        else if(option == 'd') seconds = atof(value);
+        else if(option == 'n') requests = atol(value);
+        else usage(argv[0]);
+    }
+
+    std::vector<std::string> specs(argv + arg, argv + argc);
+    if(specs.empty()) specs = {"/", "/api/status", "/api/signals", "/api/log"};
+
+    for(const std::string& spec : specs) {
+        Endpoint endpoint;
+        size_t space = spec.find(' ');
+        endpoint.method = space == std::string::npos ? "GET" : spec.substr(0, space);
+        endpoint.path = space == std::string::npos ? spec : spec.substr(space + 1);
+        endpoint.request = endpoint.method + " " + endpoint.path + " HTTP/1.1\r\nHost: " + host +
+                           "\r\nAccept-Encoding: gzip\r\nConnection: close\r\nContent-Length: 0\r\n\r\n";
+        endpoints.push_back(endpoint);
+    }
+
+    target.sin_family = AF_INET;
+    target.sin_port = htons(port);
+    if(inet_pton(AF_INET, host, &target.sin_addr) != 1) {
+        fprintf(stderr, "loadgen: host must be an IPv4 address\n");
+        return 2;
+    }
+
+    byCount = requests >= 0;
+    remaining = requests;
+    std::vector<std::vector<std::vector<Sample>>> samples(concurrency, std::vector<std::vector<Sample>>(endpoints.size()));
+    std::vector<std::thread> workers;
+
+    Clock::time_point start = Clock::now();
+    deadline = start + std::chrono::microseconds((long long)(seconds * 1e6));
+    for(int i = 0; i < concurrency; i++) {
+        workers.emplace_back(worker, (size_t)i, &samples[i]);
+    }
+    for(std::thread& thread : workers) {
+        thread.join();
+    }
+    double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+    printf("%d workers, %.1f s\n\n", concurrency, elapsed);
+    printf("%-36s %8s %7s %9s %9s %9s %9s %9s\n", "endpoint", "requests", "errors", "req/s", "p50 ms", "p99 ms", "p999 ms", "max ms");
+
+    size_t total = 0, totalErrors = 0;
+    for(size_t e = 0; e < endpoints.size(); e++) {
+        std::vector<uint32_t> latencies;
+        size_t errors = 0;
+        for(int w = 0; w < concurrency; w++) {
+            for(const Sample& sample : samples[w][e]) {
+                latencies.push_back(sample.microseconds);
+                if(sample.status == 0 || sample.status >= 500) errors++;
+            }
+        }
+        std::sort(latencies.begin(), latencies.end());
+        total += latencies.size();
+        totalErrors += errors;
+
+        std::string name = endpoints[e].method + " " + endpoints[e].path;
+        printf("%-36s %8zu %7zu %9.1f %9.2f %9.2f %9.2f %9.2f\n", name.c_str(), latencies.size(), errors,
+               latencies.size() / elapsed, percentile(latencies, 0.50), percentile(latencies, 0.99),
+               percentile(latencies, 0.999), latencies.empty() ? 0.0 : latencies.back() / 1000.0);
+    }
+    printf("%-36s %8zu %7zu %9.1f\n", "total", total, totalErrors, total / elapsed);
+
+    return totalErrors ? 1 : 0;
+}
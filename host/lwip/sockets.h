@@ -0,0 +1,10 @@
+/*
+ * Host lwip shim: the BSD socket API is the native one
+ */
+#pragma once
+
+#include <cerrno>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <unistd.h>
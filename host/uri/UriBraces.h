@@ -0,0 +1,33 @@
+/*
+ * Host UriBraces shim: "{}" captures up to the next literal character
+ */
+#pragma once
+
+#include "../WebServer.h"
+
+class UriBraces : public Uri {
+public:
+    explicit UriBraces(const char* uri) : Uri(uri) {}
+    explicit UriBraces(const String& uri) : Uri(uri) {}
+
+    Uri* clone() const override { return new UriBraces(uri); }
+
+    bool canHandle(const String& requestUri, std::vector<String>& pathArgs) override {
+        const char* pattern = uri.c_str();
+        const char* request = requestUri.c_str();
+        pathArgs.clear();
+
+        while(*pattern) {
+            if(pattern[0] == '{' && pattern[1] == '}') {
+                pattern += 2;
+                const char* end = *pattern ? strchr(request, *pattern) : request + strlen(request);
+                if(!end) return false;
+                pathArgs.push_back(String(std::string(request, end - request)));
+                request = end;
+            } else if(*pattern++ != *request++) {
+                return false;
+            }
+        }
+        return *request == 0;
+    }
+};
@@ -20,14 +20,45 @@
 
 #include <WiFi.h>
 #include <WebServer.h>
-#include <vector>
+#include <LittleFS.h>
+#include <Preferences.h>
+#include <lwip/sockets.h>
+#include <uri/UriBraces.h>
+#include <esp_heap_caps.h>
+#include <esp_vfs_eventfd.h>
+#include <unistd.h>
+#include <climits>
+#include <algorithm>
 #include <memory>
+#include <coroutine>
+#include <atomic>
+#include <type_traits>
 
 // ============================================================================
 // COMPILE-TIME CONFIGURATION FLAGS
 // ============================================================================
 #define ENABLE_IR_MODULE 1    // Set to 0 to disable IR functionality
 #define ENABLE_RF_MODULE 1    // Set to 0 to disable RF functionality
+#define DEBUG_BUILD 0         // Set to 1 to compile in full trace logging
+
+// 1 runs signal I/O and the web server in one task, as before the task
+// split; kept as the baseline for the capture jitter measurement
+#ifndef SINGLE_TASK_LAYOUT
+#define SINGLE_TASK_LAYOUT 0
+#endif
+
+// Activity log filtering. Events below LOG_LEVEL or outside LOG_CATEGORIES
+// are removed at compile time, including evaluation of their arguments.
+#ifndef LOG_LEVEL
+#if DEBUG_BUILD
+#define LOG_LEVEL LOG_LEVEL_TRACE
+#else
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+#endif
+#ifndef LOG_CATEGORIES
+#define LOG_CATEGORIES (LOG_CAT_SYSTEM | LOG_CAT_CAPTURE | LOG_CAT_REPLAY | LOG_CAT_HTTP | LOG_CAT_STORE)
+#endif
 
 // ============================================================================
 // HARDWARE PIN DEFINITIONS
@@ -43,8 +74,60 @@
 // ============================================================================
 #define MAX_SIGNAL_LENGTH 500         // Maximum raw timing values to capture
 #define MAX_STORED_SIGNALS 20         // Maximum signals to store in memory
+#define STORE_SPARE_PAYLOADS 4        // Timing buffers beyond the store awaiting reclamation
+#define STORE_READER_SLOTS 4          // Tasks copying timings out of the store at once
+#define SIGNAL_PAGE_MAX 50            // Maximum signals per /api/signals page
+#define ENVELOPE_BUCKETS 256          // Waveform preview width in min/max buckets
 #define FAILSAFE_TIMEOUT_MS 30000     // 30 second max replay duration
-#define MAX_LOG_ENTRIES 10            // Activity log size
+#define MAX_LOG_ENTRIES 10            // Activity log entries reported to clients
+#define LOG_RING_SLOTS 2048           // Activity log ring capacity (power of two)
+#define LOG_DRAIN_INTERVAL_MS 20      // Serial log drain period
+#define LOG_DRAIN_STALL_PASSES 5      // Drain passes before an unpublished slot counts as dropped
+#define LOG_DRAIN_TASK_PRIORITY 1     // Just above idle, below WiFi and loop()
+#define LOG_DRAIN_STACK_SIZE 4096     // Bytes
+#define LOG_PERSIST_INTERVAL_MS 1000  // Flash event log write batching period
+#define LOG_SEGMENT_ENTRIES 256       // Records per flash log segment (4 KB)
+#define LOG_MAX_SEGMENTS 16           // Flash log segments kept before reclaiming the oldest
+#define LOG_API_MAX_ENTRIES 64        // Maximum entries per /api/log response
+#define LOG_DIR "/log"                // Flash log segment directory
+#define JSON_BUFFER_SIZE 512          // Streaming JSON writer chunk size
+#define METRICS_BUFFER_SIZE 512       // /metrics text chunk size
+#define MAX_EVENT_CLIENTS 4           // Concurrent /api/events subscribers
+#define EVENT_CLIENT_BUFFER 768       // Per-subscriber pending send bytes
+#define EVENT_STATUS_INTERVAL_MS 100  // Minimum spacing of coalesced status events
+#define EVENT_KEEPALIVE_MS 15000      // Comment line sent to idle subscribers
+#define MAX_JOBS 8                    // Hardware jobs tracked (queued, running or finished)
+#define REPLAY_START_DEADLINE_MS 5000 // Web UI replays expire if they cannot start sooner
+#define SIGNAL_TASK_PRIORITY 10       // Above all application tasks, below the WiFi/lwIP system tasks
+#define SIGNAL_TASK_STACK_SIZE 4096   // Bytes
+#define SIGNAL_TASK_CORE APP_CPU_NUM  // Away from the WiFi stack and its interrupts
+#define WEB_TASK_PRIORITY 5           // Below lwIP (18) and WiFi (23), above loop() and the log drain
+#define WEB_TASK_STACK_SIZE 8192      // Bytes; handlers keep page buffers on the stack
+#define WEB_TASK_CORE PRO_CPU_NUM     // Next to the WiFi and lwIP tasks
+#define WEB_POLL_INTERVAL_MS 2        // handleClient() period if the listening socket is not found
+#define WEB_IDLE_WAIT_MS 1000         // Longest web task sleep; lets WebServer expire stalled clients
+#define LOOP_IDLE_WAIT_MS 1000        // Longest loop() sleep with no deadline pending
+#define LED_BLINK_INTERVAL_MS 100     // Status LED half-period while capturing
+#define RMT_TICK_HZ 1000000           // RMT resolution: one tick per captured microsecond
+#define RMT_MAX_TICKS 32767           // Longest duration one RMT symbol half can hold
+#define RMT_PROGRAM_SYMBOLS MAX_SIGNAL_LENGTH  // A timing takes at most two symbol halves
+#define TX_POLL_INTERVAL_MS 1         // Completion polling once a frame is due to have ended
+#define IR_CAPTURE_START_TIMEOUT_MS 150  // IR capture gives up if no frame starts by then
+#define MAX_FLOWS 4                   // Coroutine flows one executor runs at once
+#define PROGRAM_CACHE_BYTES 16384     // Compiled RMT programs kept for replay
+#define PROGRAM_CACHE_HEAP_FLOOR 32768  // Free heap the program cache never allocates into
+#define SELFTEST_TOLERANCE_US 100     // Loopback self-test: edge error always accepted
+#define SELFTEST_TOLERANCE_PERCENT 15 // ...or this share of the edge, if larger
+#define SELFTEST_MAX_SHIFT 2          // Edges the echo may be offset from the replay
+#define CALIBRATION_MIN_EDGES 8       // Echo edges, marks and spaces each, a calibration run needs
+#define CALIBRATION_MAX_TRIM_US 1000  // Largest correction calibration applies to an edge
+#define CALIBRATION_NAMESPACE "txcal" // NVS namespace of the output calibration
+#define IR_CARRIER_DEFAULT_HZ 38000   // IR carrier when the leader matches no known protocol
+#define IR_CARRIER_DEFAULT_DUTY 33    // Percent; a third keeps the LED cool at full peak current
+#define IR_CARRIER_MIN_HZ 20000       // Range accepted from clients
+#define IR_CARRIER_MAX_HZ 500000
+#define IR_CARRIER_MIN_DUTY 10        // Percent
+#define IR_CARRIER_MAX_DUTY 90
 
 // WiFi Access Point Configuration
 const char* AP_SSID = "ESP32-SecurityLab";
@@ -59,10 +142,124 @@ enum SignalType {
     SIGNAL_TYPE_RF
 };
 
-enum SystemState {
-    STATE_IDLE,
-    STATE_CAPTURING,
-    STATE_REPLAYING
+// Signal metadata copied out of the store for responses
+struct SignalSummary {
+    SignalType type;
+    unsigned long timestamp;
+    uint16_t length;
+    uint32_t number;
+    uint32_t revision;
+    uint32_t changed;        // Revision of the latest change, capture included
+    uint32_t carrierHz;      // IR modulation, 0 = baseband (RF)
+    uint8_t carrierDuty;     // Percent of the carrier period the LED is on
+    char id[16];
+};
+
+enum JobStatus {
+    JOB_QUEUED,
+    JOB_RUNNING,
+    JOB_DONE,        // Finished states from here on
+    JOB_FAILED,
+    JOB_CANCELLED,
+    JOB_EXPIRED      // Deadline passed before it could start
+};
+
+enum JobKind : uint8_t {
+    JOB_CAPTURE,
+    JOB_REPLAY,
+    JOB_SELFTEST,    // Replay while capturing the echo, see "Replay self-test"
+    JOB_CALIBRATE    // Self-test that updates the output calibration
+};
+
+// Scheduling classes, most urgent first
+enum JobPriority : uint8_t {
+    PRIORITY_INTERACTIVE,    // Requested from the web UI
+    PRIORITY_BACKGROUND      // Attack simulation
+};
+
+// Hardware a running job holds; jobs sharing none may run together
+enum JobResource : uint8_t {
+    RESOURCE_IR_RX = 1 << 0,
+    RESOURCE_IR_TX = 1 << 1,
+    RESOURCE_RF_RX = 1 << 2,
+    RESOURCE_RF_TX = 1 << 3
+};
+
+#define RESOURCES_RX (RESOURCE_IR_RX | RESOURCE_RF_RX)
+#define RESOURCES_TX (RESOURCE_IR_TX | RESOURCE_RF_TX)
+
+// Signals in capture order as a ring of store slots, oldest first. One index
+// covers the whole store and one each type; evictions are FIFO so they
+// always pop the front of both.
+struct SignalIndex {
+    uint16_t slots[MAX_STORED_SIGNALS];
+    uint16_t head;
+    uint16_t count;
+};
+
+// Loopback self-test grade; errors are echo minus stored timing
+struct SelfTestResult {
+    uint16_t edges;                 // Edges graded
+    uint16_t missing;               // Graded edges with no echo
+    uint16_t extra;                 // Echo edges past the end of the signal
+    uint16_t outliers;              // Edges outside tolerance
+    uint16_t worstEdge;             // Index of the largest error
+    int8_t shift;                   // Echo index minus stored index
+    bool passed;
+    int32_t markErrorUs;            // Mean error of marks (transmitter on)
+    int32_t spaceErrorUs;           // Mean error of spaces
+    uint32_t meanAbsErrorUs;
+    uint32_t maxAbsErrorUs;
+};
+
+// Hardware job, run by the signal task and tracked for /api/jobs
+struct Job {
+    uint32_t id;
+    uint32_t revision;              // jobsRevision of the last status change
+    JobKind kind;
+    JobPriority priority;
+    uint8_t resources;              // JobResource mask
+    SignalType type;
+    JobStatus status;
+    unsigned long startedAt;        // millis() when it started running
+    unsigned long deadline;         // millis() by which it must start, 0 = none
+    std::atomic<bool> cancelRequested;   // Polled by the running hardware loop
+    uint32_t signalNumber;          // JOB_CAPTURE result, valid once JOB_DONE
+    char signalId[16];              // Replay or self-test target, or JOB_CAPTURE result
+    SelfTestResult selfTest;        // JOB_SELFTEST/JOB_CALIBRATE result, valid once JOB_DONE
+    int16_t markTrimUs;             // JOB_CALIBRATE result: trims the run left, valid once JOB_DONE
+    int16_t spaceTrimUs;
+};
+
+// RMT program compiled from a stored signal, see "Compiled program cache".
+// The driver reads it while a frame is in flight, so it is not freed or
+// rewritten while users is nonzero.
+struct CompiledProgram {
+    uint32_t number;                // Signal number
+    uint32_t revision;              // Revision of the signal compiled, 0 = unused
+    uint16_t calibration;           // Transmitter calibration it was compiled with
+    uint32_t lastUsed;              // programCacheClock at the last replay
+    uint32_t durationUs;
+    uint16_t symbols;
+    uint8_t users;                  // Transmitters sending it
+    rmt_data_t* program;
+};
+
+// RMT channel of one send pin
+struct Transmitter {
+    uint8_t pin;
+    bool ready;                     // rmtInit succeeded
+    bool active;                    // Frame in flight
+    uint32_t carrierHz;             // Carrier the channel is set to, 0 = off
+    uint8_t carrierDuty;
+    uint32_t signalNumber;          // Signal of the frame in flight
+    unsigned long endsAt;           // millis() by which the frame should be out
+    CompiledProgram* sending;       // Program of the frame in flight
+    std::atomic<int16_t> markTrimUs;     // Added to every mark, see "Output calibration"
+    std::atomic<int16_t> spaceTrimUs;    // Added to every space
+    uint16_t calibration;           // Bumped whenever the trims change
+    CompiledProgram scratch;        // For programs the cache cannot hold
+    rmt_data_t scratchProgram[RMT_PROGRAM_SYMBOLS];
 };
 
 struct RawSignal {
@@ -70,12 +267,220 @@ struct RawSignal {
     unsigned long timestamp;
     uint16_t length;
     uint16_t timings[MAX_SIGNAL_LENGTH];
+    uint32_t number;
+    uint32_t revision;   // statusRevision when the signal was stored
+    uint32_t carrierHz;  // IR modulation, 0 = baseband (RF)
+    uint8_t carrierDuty; // Percent
     char id[16];
 };
 
+// Signal store metadata, published as a whole under storeSequence
+struct SignalStoreMeta {
+    SignalSummary signals[MAX_STORED_SIGNALS];   // By slot
+    uint32_t generations[MAX_STORED_SIGNALS];    // Payload generation each slot was stored with
+    uint8_t payloads[MAX_STORED_SIGNALS];        // Payload buffer of each slot
+    SignalIndex byTime;                          // All stored signals
+    SignalIndex byType[2];                       // Indexed by SignalType
+};
+
+static_assert(sizeof(SignalStoreMeta) % 4 == 0, "store metadata is published in 32-bit words");
+
+#define STORE_META_WORDS (sizeof(SignalStoreMeta) / 4)
+#define STORE_PAYLOAD_COUNT (MAX_STORED_SIGNALS + STORE_SPARE_PAYLOADS)
+
+#define PAYLOAD_WORDS (MAX_SIGNAL_LENGTH / 2)
+static_assert(MAX_SIGNAL_LENGTH % 2 == 0, "timings are copied in pairs");
+
+// Timings of a stored signal, two per word; generation moves each time the
+// buffer is reused. A reader may copy a buffer the writer is reusing, so
+// both sides go through relaxed atomic words, never plain memcpy.
+struct SignalPayload {
+    std::atomic<uint32_t> generation;
+    std::atomic<uint32_t> words[PAYLOAD_WORDS];
+};
+
+struct RetiredPayload {
+    uint8_t payload;
+    uint32_t epoch;          // storeEpoch when its signal was evicted
+};
+
+enum LogLevel : uint8_t {
+    LOG_LEVEL_TRACE,
+    LOG_LEVEL_DEBUG,
+    LOG_LEVEL_INFO,
+    LOG_LEVEL_WARN,
+    LOG_LEVEL_ERROR
+};
+
+enum LogCategory : uint8_t {
+    LOG_CAT_SYSTEM  = 1 << 0,
+    LOG_CAT_CAPTURE = 1 << 1,
+    LOG_CAT_REPLAY  = 1 << 2,
+    LOG_CAT_HTTP    = 1 << 3,
+    LOG_CAT_STORE   = 1 << 4
+};
+
+// Activity log events. Entries store the event id and its arguments only;
+// text is produced by formatActivityLog when a reader asks for it.
+enum LogEvent : uint16_t {
+    EVT_SYSTEM_INITIALIZED,
+    EVT_IR_CAPTURE_STARTED,
+    EVT_IR_CAPTURED,
+    EVT_IR_REPLAY_STARTED,
+    EVT_IR_REPLAYED,
+    EVT_RF_CAPTURED,
+    EVT_RF_REPLAY_STARTED,
+    EVT_RF_REPLAYED,
+    EVT_ATTACK_STARTED,
+    EVT_ATTACK_STOPPED,
+    EVT_FAILSAFE_TIMEOUT,
+    EVT_IR_EDGE_FILTERED,
+    EVT_RF_EDGE_FILTERED,
+    EVT_CAPTURE_NO_SIGNAL,
+    EVT_HTTP_BUSY,
+    EVT_SIGNAL_STORED,
+    EVT_SIGNAL_EVICTED,
+    EVT_JOB_CANCELLED,
+    EVT_JOB_EXPIRED,
+    EVT_SELFTEST_PASSED,
+    EVT_SELFTEST_FAILED,
+    EVT_IR_CALIBRATED,
+    EVT_RF_CALIBRATED,
+    EVT_COUNT
+};
+
+// Format, severity and subsystem of each event; arguments are (signal, length)
+struct LogEventInfo {
+    const char* format;
+    LogLevel level;
+    LogCategory category;
+};
+
+constexpr LogEventInfo LOG_EVENTS[EVT_COUNT] = {
+    { "System initialized",                      LOG_LEVEL_INFO,  LOG_CAT_SYSTEM  },
+    { "IR capture started",                      LOG_LEVEL_INFO,  LOG_CAT_CAPTURE },
+    { "IR signal captured: IR_%lu (%u timings)", LOG_LEVEL_INFO,  LOG_CAT_CAPTURE },
+    { "Replaying IR signal",                     LOG_LEVEL_INFO,  LOG_CAT_REPLAY  },
+    { "IR signal replayed: IR_%lu",              LOG_LEVEL_INFO,  LOG_CAT_REPLAY  },
+    { "RF signal captured: RF_%lu (%u timings)", LOG_LEVEL_INFO,  LOG_CAT_CAPTURE },
+    { "Replaying RF signal",                     LOG_LEVEL_INFO,  LOG_CAT_REPLAY  },
+    { "RF signal replayed: RF_%lu",              LOG_LEVEL_INFO,  LOG_CAT_REPLAY  },
+    { "Attack simulation started",               LOG_LEVEL_INFO,  LOG_CAT_REPLAY  },
+    { "Attack simulation stopped",               LOG_LEVEL_INFO,  LOG_CAT_REPLAY  },
+    { "FAILSAFE: Timeout triggered",             LOG_LEVEL_WARN,  LOG_CAT_SYSTEM  },
+    { "IR edge filtered: IR_%lu (%u us)",        LOG_LEVEL_TRACE, LOG_CAT_CAPTURE },
+    { "RF edge filtered: RF_%lu (%u us)",        LOG_LEVEL_TRACE, LOG_CAT_CAPTURE },
+    { "No signal captured: #%lu (%u timings)",   LOG_LEVEL_DEBUG, LOG_CAT_CAPTURE },
+    { "Request rejected: system busy",           LOG_LEVEL_WARN,  LOG_CAT_HTTP    },
+    { "Signal stored: #%lu",                     LOG_LEVEL_DEBUG, LOG_CAT_STORE   },
+    { "Signal evicted: #%lu",                    LOG_LEVEL_INFO,  LOG_CAT_STORE   },
+    { "Job cancelled: #%lu",                     LOG_LEVEL_INFO,  LOG_CAT_SYSTEM  },
+    { "Job expired before starting: #%lu",       LOG_LEVEL_WARN,  LOG_CAT_SYSTEM  },
+    { "Self-test passed: #%lu (max %u us off)",  LOG_LEVEL_INFO,  LOG_CAT_REPLAY  },
+    { "Self-test failed: #%lu (max %u us off)",  LOG_LEVEL_WARN,  LOG_CAT_REPLAY  },
+    { "IR output calibrated from IR_%lu",        LOG_LEVEL_INFO,  LOG_CAT_REPLAY  },
+    { "RF output calibrated from RF_%lu",        LOG_LEVEL_INFO,  LOG_CAT_REPLAY  }
+};
+
+constexpr bool logEventEnabled(LogEvent event) {
+    return LOG_EVENTS[event].level >= LOG_LEVEL &&
+           (LOG_EVENTS[event].category & (LOG_CATEGORIES)) != 0;
+}
+
+// Logging front-end. Disabled events compile to nothing, arguments included.
+#define LOG_EVENT(event, ...) \
+    do { \
+        if constexpr (logEventEnabled(event)) { \
+            addActivityLog(event __VA_OPT__(,) __VA_ARGS__); \
+        } \
+    } while(0)
+
 struct ActivityLogEntry {
-    unsigned long timestamp;
-    char message[64];
+    uint32_t timestamp;
+    uint16_t event;
+    uint16_t length;   // Signal length in timings, if any
+    uint32_t signal;   // Signal number, if any
+};
+
+// One preallocated slot of the activity log ring. The sequence number is
+// odd while a producer is filling the slot and even once it is published.
+struct ActivityLogSlot {
+    std::atomic<uint32_t> sequence;
+    ActivityLogEntry entry;
+};
+
+// Activity log entry as stored in the flash event log
+struct PersistedLogRecord {
+    uint32_t sequence;
+    ActivityLogEntry entry;
+};
+
+// Latency histogram bucket upper bounds, in microseconds and as the
+// Prometheus "le" label (seconds). Values above the last go to +Inf.
+#define LATENCY_BUCKETS 13
+constexpr uint32_t LATENCY_BOUNDS_US[LATENCY_BUCKETS] = {
+    100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000, 500000, 1000000
+};
+constexpr const char* LATENCY_BOUNDS_LABEL[LATENCY_BUCKETS] = {
+    "0.0001", "0.00025", "0.0005", "0.001", "0.0025", "0.005", "0.01",
+    "0.025", "0.05", "0.1", "0.25", "0.5", "1"
+};
+
+// Relaxed atomic adds only, so recording costs a few cycles on any task.
+// The sum is 64-bit (a 32-bit one wraps after ~71 minutes of latency); on
+// ESP32 that add goes through the toolchain's short critical section.
+struct LatencyHistogram {
+    std::atomic<uint32_t> buckets[LATENCY_BUCKETS + 1];
+    std::atomic<uint64_t> sumMicros;
+    
+    void record(uint32_t micros) {
+        size_t i = 0;
+        while(i < LATENCY_BUCKETS && micros > LATENCY_BOUNDS_US[i]) i++;
+        buckets[i].fetch_add(1, std::memory_order_relaxed);
+        sumMicros.fetch_add(micros, std::memory_order_relaxed);
+    }
+};
+
+// Instrumented HTTP routes; names are the route patterns
+enum HttpEndpoint {
+    ENDPOINT_ROOT,
+    ENDPOINT_STATUS,
+    ENDPOINT_SIGNALS,
+    ENDPOINT_SIGNAL_TIMINGS,
+    ENDPOINT_SIGNAL_ENVELOPE,
+    ENDPOINT_SIGNAL_CARRIER,
+    ENDPOINT_LOG,
+    ENDPOINT_EVENTS,
+    ENDPOINT_CAPTURE,
+    ENDPOINT_JOB,
+    ENDPOINT_JOB_CANCEL,
+    ENDPOINT_REPLAY,
+    ENDPOINT_SELFTEST,
+    ENDPOINT_CALIBRATE,
+    ENDPOINT_ATTACK_START,
+    ENDPOINT_ATTACK_STOP,
+    ENDPOINT_METRICS,
+    ENDPOINT_COUNT
+};
+
+const char* const ENDPOINT_NAMES[ENDPOINT_COUNT] = {
+    "/", "/api/status", "/api/signals", "/api/signal/{}/timings", "/api/signal/{}/envelope",
+    "/api/signal/{}/carrier", "/api/log", "/api/events", "/api/capture", "/api/jobs/{}",
+    "/api/jobs/{}/cancel", "/api/replay", "/api/selftest", "/api/calibrate", "/api/attack/start",
+    "/api/attack/stop", "/metrics"
+};
+
+struct Metrics {
+    LatencyHistogram loopLatency;
+    LatencyHistogram endpointLatency[ENDPOINT_COUNT];
+    std::atomic<uint32_t> captures;
+    std::atomic<uint32_t> capturesSucceeded;
+    std::atomic<uint32_t> capturesFailed;
+    std::atomic<uint32_t> edgesCaptured;
+    std::atomic<uint32_t> edgesFiltered;
+    std::atomic<uint32_t> replays;
+    std::atomic<uint32_t> programCacheHits;
+    std::atomic<uint32_t> programCacheMisses;
 };
 
 // ============================================================================
@@ -83,226 +488,896 @@ struct ActivityLogEntry {
 // ============================================================================
 
 WebServer server(80);
-std::vector<RawSignal> capturedSignals;
-std::vector<ActivityLogEntry> activityLog;
+Metrics metrics;
+ActivityLogSlot activityLog[LOG_RING_SLOTS];
+std::atomic<uint32_t> activityLogHead(0);
+std::atomic<uint32_t> activityLogDropped(0);
+
+// Flash event log state
+bool logStoreReady = false;
+SemaphoreHandle_t logStoreMutex = NULL;
+uint32_t logSequenceBase = 0;                 // Sequence number of ring ticket 0
+uint32_t logPersistedEnd = 0;                 // Sequence after the last persisted record
+uint32_t logSegments[LOG_MAX_SEGMENTS];       // First sequence of each segment, oldest first
+uint8_t logSegmentCount = 0;
+
+std::atomic<uint32_t> signalCounter(0);      // Bumped by the signal task, read by the web task
+
+// Signal store, see "Signal store concurrency". storeDraft and the
+// payload free and retired lists belong to the holder of storeWriteMutex.
+SemaphoreHandle_t storeWriteMutex = NULL;
+SignalStoreMeta storeDraft;
+std::atomic<uint32_t> storeMetaWords[STORE_META_WORDS];
+std::atomic<uint32_t> storeSequence(0);                        // Odd while publishing
+SignalPayload signalPayloads[STORE_PAYLOAD_COUNT];
+std::atomic<uint32_t> storeEpoch(1);
+std::atomic<uint32_t> storeReaderEpochs[STORE_READER_SLOTS];   // 0 = not pinned
+uint8_t freePayloads[STORE_PAYLOAD_COUNT];
+size_t freePayloadCount = 0;
+RetiredPayload retiredPayloads[STORE_PAYLOAD_COUNT];
+size_t retiredPayloadCount = 0;
+
+// Hardware jobs, indexed by id % MAX_JOBS; see "Job scheduler"
+Job jobs[MAX_JOBS];
+uint32_t nextJobId = 1;
+std::atomic<uint32_t> jobsRevision(0);
+SemaphoreHandle_t jobsMutex = NULL;
+std::atomic<uint8_t> busyResources(0);       // Held by running jobs
 
-SystemState currentState = STATE_IDLE;
-unsigned long stateStartTime = 0;
-unsigned long signalCounter = 0;
+// Task handoff, see "Task layout"
+TaskHandle_t signalTaskHandle = NULL;
+TaskHandle_t loopTaskHandle = NULL;
+int webWakeFd = -1;                           // eventfd the web task selects on
+int webListenFd = -1;                         // WebServer's listening socket
 
-// Attack simulation parameters
-bool attackSimulationActive = false;
+// RMT transmitters by SignalType; set up in setup(), then signal task only
+Transmitter transmitters[2];
+
+// Compiled program cache, signal task only; see "Compiled program cache"
+CompiledProgram programCache[MAX_STORED_SIGNALS];
+uint32_t programCacheClock = 0;
+std::atomic<uint32_t> programCacheBytes(0);  // Also read by /metrics
+
+// Change tracking for /api/status. statusRevision is bumped by every change
+// a client can see (state, signal store, log); signalsRevision only by
+// signal store changes so unchanged collections are skipped in O(1).
+// Revisions start at a random base each boot so stale client revisions
+// from before a reboot are recognised and answered with a full status.
+std::atomic<uint32_t> statusRevision(1);
+uint32_t revisionBase = 1;
+std::atomic<uint32_t> signalsRevision(1);
+
+// Attack simulation, run by attackFlow() on loop()
+std::atomic<bool> attackSimulationActive(false);
+std::atomic<uint32_t> attackRun(0);          // Bumped by each start, which restarts the flow
 int attackDelayMs = 1000;
-int attackSignalIndex = 0;
-unsigned long lastAttackTime = 0;
 
 // ============================================================================
 // UTILITY FUNCTIONS
 // ============================================================================
 
-void setStatusLED(SystemState state) {
-    switch(state) {
-        case STATE_IDLE:
-            digitalWrite(STATUS_LED_PIN, LOW);
-            break;
-        case STATE_CAPTURING:
-            // Blink fast during capture
-            digitalWrite(STATUS_LED_PIN, (millis() / 100) % 2);
-            break;
-        case STATE_REPLAYING:
-            digitalWrite(STATUS_LED_PIN, HIGH);
-            break;
+// Status LED from the resources running jobs hold
+void setStatusLED(uint8_t busy) {
+    if(busy & RESOURCES_TX) {
+        digitalWrite(STATUS_LED_PIN, HIGH);
+    } else if(busy & RESOURCES_RX) {
+        // Blink fast during capture
+        digitalWrite(STATUS_LED_PIN, (millis() / LED_BLINK_INTERVAL_MS) % 2);
+    } else {
+        digitalWrite(STATUS_LED_PIN, LOW);
     }
 }
 
-void addActivityLog(const char* message) {
-    ActivityLogEntry entry;
-    entry.timestamp = millis();
-    strncpy(entry.message, message, sizeof(entry.message) - 1);
-    entry.message[sizeof(entry.message) - 1] = '\0';
+// State reported to clients, derived the same way
+const char* activityName() {
+    uint8_t busy = busyResources.load(std::memory_order_relaxed);
+    if(busy & RESOURCES_TX) return "REPLAYING";
+    if(busy & RESOURCES_RX) return "CAPTURING";
+    return "IDLE";
+}
+
+// loop() sleeps until its next deadline; state changes move the deadlines
+void wakeLoopTask() {
+    if(loopTaskHandle && xTaskGetCurrentTaskHandle() != loopTaskHandle) {
+        xTaskNotifyGive(loopTaskHandle);
+    }
+}
+
+// The web task sleeps in select(); this makes it return
+void wakeWebTask() {
+    if(webWakeFd < 0) return;
+    uint64_t one = 1;
+    if(write(webWakeFd, &one, sizeof(one)) < 0) return;
+}
+
+/*
+ * Activity log ring (lock-free, multi-producer)
+ *
+ * Each producer claims a ticket with a single atomic increment and owns the
+ * slot (ticket % LOG_RING_SLOTS) until it publishes it. No allocation and no
+ * locks, so it is safe from capture loops, HTTP handlers and interrupts.
+ * A producer that finds its slot still being written by a lapped producer
+ * drops its message rather than waiting. Serial output happens later in
+ * logDrainTask, never on the caller's path.
+ */
+void addActivityLog(LogEvent event, uint32_t signal = 0, uint16_t length = 0) {
+    uint32_t ticket = activityLogHead.fetch_add(1, std::memory_order_relaxed);
+    ActivityLogSlot& slot = activityLog[ticket & (LOG_RING_SLOTS - 1)];
     
-    activityLog.push_back(entry);
+    uint32_t previous = slot.sequence.load(std::memory_order_relaxed);
+    do {
+        if((previous & 1) || previous > ticket * 2) {
+            return; // Slot busy or already reused by a newer entry
+        }
+    } while(!slot.sequence.compare_exchange_weak(previous, ticket * 2 + 1,
+                                                 std::memory_order_acquire,
+                                                 std::memory_order_relaxed));
     
-    // Keep only last MAX_LOG_ENTRIES
-    if(activityLog.size() > MAX_LOG_ENTRIES) {
-        activityLog.erase(activityLog.begin());
-    }
+    slot.entry.timestamp = millis();
+    slot.entry.event = event;
+    slot.entry.length = length;
+    slot.entry.signal = signal;
     
-    Serial.println(message);
+    slot.sequence.store(ticket * 2 + 2, std::memory_order_release);
+    statusRevision.fetch_add(1, std::memory_order_relaxed);
 }
 
-// Generate unique signal ID
-void generateSignalId(char* buffer, size_t size, SignalType type) {
-    const char* prefix = (type == SIGNAL_TYPE_IR) ? "IR" : "RF";
-    snprintf(buffer, size, "%s_%lu", prefix, signalCounter++);
+size_t formatActivityLog(const ActivityLogEntry& entry, char* buffer, size_t size) {
+    if(entry.event >= EVT_COUNT) {
+        return snprintf(buffer, size, "Unknown event %u", entry.event);
+    }
+    return snprintf(buffer, size, LOG_EVENTS[entry.event].format,
+                    (unsigned long)entry.signal, (unsigned)entry.length);
+}
+
+enum LogSlotStatus {
+    LOG_SLOT_READY,     // Entry copied
+    LOG_SLOT_PENDING,   // Ticket claimed but not yet published
+    LOG_SLOT_LOST       // Entry overwritten or dropped by its producer
+};
+
+// Copy the entry for a ring ticket, validating it against the slot sequence
+LogSlotStatus readActivityLogSlot(uint32_t ticket, ActivityLogEntry& entry) {
+    const ActivityLogSlot& slot = activityLog[ticket & (LOG_RING_SLOTS - 1)];
+    uint32_t expected = ticket * 2 + 2;
+    uint32_t sequence = slot.sequence.load(std::memory_order_acquire);
+    
+    if(sequence < expected) return LOG_SLOT_PENDING;
+    if(sequence != expected) return LOG_SLOT_LOST;
+    
+    entry = slot.entry;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if(slot.sequence.load(std::memory_order_relaxed) != expected) return LOG_SLOT_LOST;
+    
+    return LOG_SLOT_READY;
 }
 
 // ============================================================================
-// IR CAPTURE AND REPLAY FUNCTIONS
+// PERSISTENT EVENT LOG
 // ============================================================================
 
-#if ENABLE_IR_MODULE
-
 /*
- * IR Signal Capture
- * 
- * VULNERABILITY DEMONSTRATED:
- * Most consumer IR remotes use simple pulse-width modulation without
- * authentication. This allows trivial replay attacks.
- * 
- * WHY THIS WORKS ON INSECURE SYSTEMS:
- * - No rolling codes
- * - No encryption
- * - No timestamp validation
- * - Device accepts any valid timing pattern
- * 
- * SECURE ALTERNATIVES:
- * - Challenge-response authentication
- * - Time-based one-time codes
- * - Encrypted command payloads
+ * Flash-backed event log
+ *
+ * Ring entries are appended to fixed-size segment files on LittleFS, each
+ * named after the sequence number of its first record. Sequence numbers
+ * continue across reboots (logSequenceBase is the sequence of ring ticket 0),
+ * so clients can fetch only new entries with /api/log?since=N. When more
+ * than LOG_MAX_SEGMENTS exist the oldest segment file is deleted whole.
+ * A new segment is started at boot and after any gap in the sequence, so
+ * a record's position in its segment follows from its sequence number.
  */
+void logSegmentPath(char* buffer, size_t size, uint32_t firstSequence) {
+    snprintf(buffer, size, LOG_DIR "/%08lx.bin", (unsigned long)firstSequence);
+}
 
-bool captureIRSignal(RawSignal& signal) {
-    const unsigned long timeout = 150000; // 150ms timeout
-    const unsigned int minPulse = 50;     // Minimum pulse width (microseconds)
-    const unsigned int maxPulse = 15000;  // Maximum pulse width
+bool logStoreBegin() {
+    if(!LittleFS.begin(true)) {
+        return false;
+    }
+    if(!LittleFS.exists(LOG_DIR)) {
+        LittleFS.mkdir(LOG_DIR);
+    }
     
-    signal.type = SIGNAL_TYPE_IR;
-    signal.length = 0;
-    signal.timestamp = millis();
-    generateSignalId(signal.id, sizeof(signal.id), SIGNAL_TYPE_IR);
+    // Collect segment start sequences, oldest first
+    File dir = LittleFS.open(LOG_DIR);
+    if(!dir) return false;
     
-    unsigned long startTime = micros();
-    int currentState = digitalRead(IR_RECV_PIN);
-    int lastState = currentState;
-    unsigned long lastChange = startTime;
+    for(File file = dir.openNextFile(); file; file = dir.openNextFile()) {
+        const char* name = strrchr(file.name(), '/');
+        name = name ? name + 1 : file.name();
+        uint32_t first = strtoul(name, NULL, 16);
+        uint32_t records = file.size() / sizeof(PersistedLogRecord);
+        file.close();
+        
+        if(logSegmentCount == LOG_MAX_SEGMENTS) {
+            // More segments on flash than configured; drop the oldest
+            char path[32];
+            logSegmentPath(path, sizeof(path), logSegments[0]);
+            LittleFS.remove(path);
+            memmove(logSegments, logSegments + 1, (LOG_MAX_SEGMENTS - 1) * sizeof(logSegments[0]));
+            logSegmentCount--;
+        }
+        
+        uint8_t i = logSegmentCount;
+        while(i > 0 && logSegments[i - 1] > first) {
+            logSegments[i] = logSegments[i - 1];
+            i--;
+        }
+        logSegments[i] = first;
+        logSegmentCount++;
+        
+        if(first + records > logPersistedEnd) {
+            logPersistedEnd = first + records;
+        }
+    }
+    dir.close();
+    
+    logSequenceBase = logPersistedEnd;
+    return true;
+}
+
+// Append records to the newest segment, starting a new one if requested
+void appendLogRecords(const PersistedLogRecord* records, size_t count, bool newSegment) {
+    char path[32];
+    
+    xSemaphoreTake(logStoreMutex, portMAX_DELAY);
     
-    // Wait for signal start (LOW)
-    while(digitalRead(IR_RECV_PIN) == HIGH) {
-        if(micros() - startTime > timeout) {
-            return false; // No signal detected
+    if(newSegment || logSegmentCount == 0) {
+        if(logSegmentCount == LOG_MAX_SEGMENTS) {
+            logSegmentPath(path, sizeof(path), logSegments[0]);
+            LittleFS.remove(path);
+            memmove(logSegments, logSegments + 1, (LOG_MAX_SEGMENTS - 1) * sizeof(logSegments[0]));
+            logSegmentCount--;
         }
+        logSegments[logSegmentCount++] = records[0].sequence;
     }
     
-    addActivityLog("IR capture started");
+    logSegmentPath(path, sizeof(path), logSegments[logSegmentCount - 1]);
+    File file = LittleFS.open(path, "a");
+    if(file) {
+        file.write((const uint8_t*)records, count * sizeof(PersistedLogRecord));
+        file.close();
+        logPersistedEnd = records[count - 1].sequence + 1;
+    }
     
-    // Capture timing data
-    while(signal.length < MAX_SIGNAL_LENGTH) {
-        currentState = digitalRead(IR_RECV_PIN);
-        unsigned long now = micros();
+    xSemaphoreGive(logStoreMutex);
+}
+
+// Read persisted records with sequence >= from, oldest first
+size_t readPersistedLog(uint32_t from, PersistedLogRecord* out, size_t maxRecords) {
+    size_t count = 0;
+    char path[32];
+    
+    xSemaphoreTake(logStoreMutex, portMAX_DELAY);
+    
+    for(uint8_t i = 0; i < logSegmentCount && count < maxRecords; i++) {
+        uint32_t first = logSegments[i];
+        uint32_t next = (i + 1 < logSegmentCount) ? logSegments[i + 1] : logPersistedEnd;
+        if(from >= next) continue;
         
-        if(currentState != lastState) {
-            unsigned long duration = now - lastChange;
-            
-            if(duration >= minPulse && duration <= maxPulse) {
-                signal.timings[signal.length++] = (uint16_t)duration;
-            }
-            
-            lastChange = now;
-            lastState = currentState;
+        logSegmentPath(path, sizeof(path), first);
+        File file = LittleFS.open(path, "r");
+        if(!file) continue;
+        
+        if(from > first) {
+            file.seek((from - first) * sizeof(PersistedLogRecord));
         }
+        size_t wanted = (maxRecords - count) * sizeof(PersistedLogRecord);
+        size_t got = file.read((uint8_t*)(out + count), wanted) / sizeof(PersistedLogRecord);
+        file.close();
         
-        // End of signal detection (silence)
-        if(now - lastChange > timeout) {
+        count += got;
+        if(got > 0) from = out[count - 1].sequence + 1;
+    }
+    
+    xSemaphoreGive(logStoreMutex);
+    return count;
+}
+
+// Move newly published ring entries to flash in batches
+void persistActivityLog() {
+    static uint32_t cursor = 0;
+    static uint32_t segmentRecords = LOG_SEGMENT_ENTRIES; // Start a new segment at boot
+    static bool stalled = false;
+    static bool gap = false;
+    
+    if(!logStoreReady) return;
+    
+    uint32_t head = activityLogHead.load(std::memory_order_acquire);
+    if(head - cursor > LOG_RING_SLOTS) {
+        cursor = head - LOG_RING_SLOTS;
+        gap = true;
+    }
+    
+    PersistedLogRecord batch[32];
+    size_t count = 0;
+    bool batchStartsSegment = false;
+    
+    while(cursor != head) {
+        ActivityLogEntry entry;
+        LogSlotStatus status = readActivityLogSlot(cursor, entry);
+        
+        if(status == LOG_SLOT_PENDING && !stalled) {
+            stalled = true; // Retry once on the next pass
             break;
         }
+        stalled = false;
+        
+        if(status != LOG_SLOT_READY) {
+            cursor++;
+            gap = true;
+            continue;
+        }
+        
+        bool newSegment = gap || segmentRecords >= LOG_SEGMENT_ENTRIES;
+        if(newSegment || count == sizeof(batch) / sizeof(batch[0])) {
+            if(count > 0) {
+                appendLogRecords(batch, count, batchStartsSegment);
+                count = 0;
+            }
+            batchStartsSegment = newSegment;
+            if(newSegment) {
+                segmentRecords = 0;
+                gap = false;
+            }
+        }
+        
+        batch[count].sequence = logSequenceBase + cursor;
+        batch[count].entry = entry;
+        count++;
+        segmentRecords++;
+        cursor++;
     }
     
-    if(signal.length > 10) { // Minimum valid signal length
-        char logMsg[64];
-        snprintf(logMsg, sizeof(logMsg), "IR signal captured: %s (%d timings)", 
-                 signal.id, signal.length);
-        addActivityLog(logMsg);
-        return true;
+    if(count > 0) {
+        appendLogRecords(batch, count, batchStartsSegment);
     }
-    
-    return false;
 }
 
-void replayIRSignal(const RawSignal& signal) {
-    if(signal.type != SIGNAL_TYPE_IR) return;
+/*
+ * Serial log drain
+ *
+ * Runs as a low-priority task and prints ring entries in order. It only
+ * writes what fits in the UART TX buffer, so it never blocks on the baud
+ * rate; entries that are overwritten before it catches up are counted in
+ * activityLogDropped instead of stalling producers. The same task batches
+ * entries to the flash log every LOG_PERSIST_INTERVAL_MS.
+ */
+void drainActivityLog() {
+    static uint32_t cursor = 0;
+    static uint8_t stalledPasses = 0;
     
-    addActivityLog("Replaying IR signal");
+    uint32_t head = activityLogHead.load(std::memory_order_acquire);
     
-    // Replay the captured timing pattern
-    for(uint16_t i = 0; i < signal.length; i++) {
-        if(i % 2 == 0) {
-            digitalWrite(IR_SEND_PIN, HIGH);
-        } else {
-            digitalWrite(IR_SEND_PIN, LOW);
-        }
-        delayMicroseconds(signal.timings[i]);
+    if(head - cursor > LOG_RING_SLOTS) {
+        activityLogDropped.fetch_add(head - cursor - LOG_RING_SLOTS, std::memory_order_relaxed);
+        cursor = head - LOG_RING_SLOTS;
+        stalledPasses = 0;
     }
-    digitalWrite(IR_SEND_PIN, LOW);
     
-    char logMsg[64];
-    snprintf(logMsg, sizeof(logMsg), "IR signal replayed: %s", signal.id);
-    addActivityLog(logMsg);
+    while(cursor != head) {
+        ActivityLogEntry entry;
+        LogSlotStatus status = readActivityLogSlot(cursor, entry);
+        
+        if(status == LOG_SLOT_PENDING) {
+            // Producer still writing; give it a few passes before giving up
+            if(++stalledPasses < LOG_DRAIN_STALL_PASSES) break;
+            status = LOG_SLOT_LOST;
+        }
+        
+        if(status == LOG_SLOT_LOST) {
+            activityLogDropped.fetch_add(1, std::memory_order_relaxed);
+            cursor++;
+            stalledPasses = 0;
+            continue;
+        }
+        
+        char message[64];
+        size_t length = formatActivityLog(entry, message, sizeof(message));
+        if(length >= sizeof(message)) length = sizeof(message) - 1;
+        if(Serial.availableForWrite() < (int)(length + 2)) {
+            break; // UART backpressure, retry next pass
+        }
+        
+        Serial.write(message, length);
+        Serial.write("\r\n", 2);
+        cursor++;
+        stalledPasses = 0;
+    }
 }
 
-#endif // ENABLE_IR_MODULE
+void logDrainTask(void* param) {
+    uint32_t reportedDropped = 0;
+    TickType_t lastPersist = xTaskGetTickCount();
+    
+    for(;;) {
+        drainActivityLog();
+        
+        if(xTaskGetTickCount() - lastPersist >= pdMS_TO_TICKS(LOG_PERSIST_INTERVAL_MS)) {
+            persistActivityLog();
+            lastPersist = xTaskGetTickCount();
+        }
+        
+        uint32_t dropped = activityLogDropped.load(std::memory_order_relaxed);
+        if(dropped != reportedDropped && Serial.availableForWrite() >= 48) {
+            Serial.printf("[log] %lu messages dropped\r\n", (unsigned long)dropped);
+            reportedDropped = dropped;
+        }
+        
+        vTaskDelay(pdMS_TO_TICKS(LOG_DRAIN_INTERVAL_MS));
+    }
+}
 
 // ============================================================================
-// RF CAPTURE AND REPLAY FUNCTIONS
+// RMT TRANSMIT ENGINE
 // ============================================================================
 
-#if ENABLE_RF_MODULE
-
 /*
- * RF 433MHz Signal Capture
- * 
- * VULNERABILITY DEMONSTRATED:
- * Simple fixed-code RF systems transmit the same signal every time.
- * These are vulnerable to replay attacks.
- * 
- * WHY THIS WORKS ON INSECURE SYSTEMS:
- * - Static codes (same every press)
- * - No encryption
- * - No authentication handshake
- * - Receiver accepts any matching code
- * 
- * SYSTEMS THIS DOES NOT AFFECT:
- * - Rolling code systems (KeeLoq, etc.)
- * - Encrypted RF protocols
- * - Challenge-response systems
- * - Modern car key fobs with crypto
- * 
- * SECURE ALTERNATIVES:
- * - Rolling code algorithms
- * - AES encryption
- * - Frequency hopping
- * - Authentication protocols
+ * RMT transmit engine
+ *
+ * A replay is compiled into RMT symbols, each holding two (level,
+ * duration) halves, and handed to the peripheral with rmtWriteAsync().
+ * The RMT clocks the edges out on its own with tick accuracy, so replay
+ * no longer busy-waits a CPU for the length of the frame and IRQs or task
+ * switches cannot stretch an edge. The signal task polls
+ * transmitCompleted() from the time the frame is due to end and then
+ * reports the job done; see signalTask().
+ *
+ * Each send pin has its own channel and program buffer, so an IR and an
+ * RF frame can be in flight together while captures keep running.
+ *
+ * IR frames are modulated by the RMT carrier generator: marks are sent as
+ * the signal's carrierHz at carrierDuty, spaces as a dark LED. The
+ * carrier is channel configuration, so it costs nothing per edge and is
+ * only rewritten when the next frame asks for a different one.
  */
 
-bool captureRFSignal(RawSignal& signal) {
-    const unsigned long timeout = 500000; // 500ms timeout
-    const unsigned int minPulse = 100;
-    const unsigned int maxPulse = 20000;
-    
-    signal.type = SIGNAL_TYPE_RF;
-    signal.length = 0;
-    signal.timestamp = millis();
-    generateSignalId(signal.id, sizeof(signal.id), SIGNAL_TYPE_RF);
-    
-    unsigned long startTime = micros();
-    int currentState = digitalRead(RF_RECV_PIN);
-    int lastState = currentState;
-    unsigned long lastChange = startTime;
+bool beginTransmitter(SignalType type, uint8_t pin) {
+    Transmitter& tx = transmitters[type];
+    tx.pin = pin;
+    tx.active = false;
+    tx.sending = NULL;
+    tx.carrierHz = 0;
+    tx.carrierDuty = 0;
+    tx.ready = rmtInit(pin, RMT_TX_MODE, RMT_MEM_NUM_BLOCKS_1, RMT_TICK_HZ) && rmtSetEOT(pin, LOW);
+    return tx.ready;
+}
+
+/*
+ * Compile timings into RMT symbols, marks HIGH and spaces LOW, with the
+ * transmitter's output calibration added to each. Timings longer than
+ * RMT_MAX_TICKS are split over equal halves of the same level (65535 is
+ * clamped to 65534 to fit two). Returns the symbol count; durationUs
+ * receives the frame length.
+ */
+size_t compileRmtProgram(const RawSignal& signal, const Transmitter& tx, rmt_data_t* program, uint32_t* durationUs) {
+    int32_t markTrim = tx.markTrimUs.load(std::memory_order_relaxed);
+    int32_t spaceTrim = tx.spaceTrimUs.load(std::memory_order_relaxed);
+    size_t halves = 0;
+    uint32_t total = 0;
     
-    // Wait for signal activity
-    while(micros() - startTime < timeout) {
-        currentState = digitalRead(RF_RECV_PIN);
+    for(uint16_t i = 0; i < signal.length; i++) {
+        int32_t trimmed = (int32_t)signal.timings[i] + (i % 2 == 0 ? markTrim : spaceTrim);
+        uint32_t ticks = min((uint32_t)max(trimmed, (int32_t)1), 2u * RMT_MAX_TICKS);
+        uint32_t parts = (ticks + RMT_MAX_TICKS - 1) / RMT_MAX_TICKS;
+        uint32_t level = i % 2 == 0 ? HIGH : LOW;
         
-        if(currentState != lastState) {
-            unsigned long now = micros();
-            unsigned long duration = now - lastChange;
-            
-            if(duration >= minPulse && duration <= maxPulse) {
+        for(uint32_t part = 0; part < parts; part++) {
+            uint32_t duration = ticks / parts + (part < ticks % parts ? 1 : 0);
+            rmt_data_t& symbol = program[halves / 2];
+            if(halves % 2 == 0) {
+                symbol.val = 0;     // An unused second half ends the frame
+                symbol.duration0 = duration;
+                symbol.level0 = level;
+            } else {
+                symbol.duration1 = duration;
+                symbol.level1 = level;
+            }
+            halves++;
+        }
+        total += ticks;
+    }
+    
+    *durationUs = total;
+    return (halves + 1) / 2;
+}
+
+/*
+ * Compiled program cache
+ *
+ * Replays reuse the RMT program built the first time a signal was sent,
+ * so a repeat replay neither copies the timings out of the store nor
+ * walks them, and its first edge goes out as soon as the job starts.
+ * Entries are keyed by signal number and tagged with the revision and
+ * transmitter calibration they were compiled from. Stored timings never
+ * change, so matching tags mean the program is current; an evicted
+ * signal's entry is dropped with it, and entries of an older calibration
+ * are never hit again and age out. The carrier is channel configuration,
+ * not part of a program, so carrier edits keep the entry.
+ *
+ * Programs live on the heap, at most PROGRAM_CACHE_BYTES of them and
+ * never pushing free heap below PROGRAM_CACHE_HEAP_FLOOR. To make room
+ * the least recently replayed program that is not being sent is dropped.
+ * A program that still does not fit is sent from the transmitter's
+ * scratch buffer, so a replay never fails for want of cache.
+ */
+
+CompiledProgram* findProgram(uint32_t number, uint32_t revision, uint16_t calibration) {
+    for(CompiledProgram& entry : programCache) {
+        if(entry.revision == revision && entry.number == number && entry.calibration == calibration) return &entry;
+    }
+    return NULL;
+}
+
+void dropProgram(CompiledProgram& entry) {
+    heap_caps_free(entry.program);
+    programCacheBytes.fetch_sub(entry.symbols * sizeof(rmt_data_t), std::memory_order_relaxed);
+    entry.program = NULL;
+    entry.revision = 0;
+}
+
+// A signal left the store; drop its program unless a frame is using it
+void forgetProgram(uint32_t number) {
+    for(CompiledProgram& entry : programCache) {
+        if(entry.revision != 0 && entry.number == number && entry.users == 0) dropProgram(entry);
+    }
+}
+
+// Least recently used entry not being sent, or NULL
+CompiledProgram* programVictim() {
+    CompiledProgram* victim = NULL;
+    for(CompiledProgram& entry : programCache) {
+        if(entry.revision == 0 || entry.users != 0) continue;
+        if(!victim || (int32_t)(entry.lastUsed - victim->lastUsed) < 0) victim = &entry;
+    }
+    return victim;
+}
+
+// Copy a freshly compiled program into the cache; NULL if it cannot be held
+CompiledProgram* cacheProgram(const CompiledProgram& compiled) {
+    size_t bytes = compiled.symbols * sizeof(rmt_data_t);
+    if(bytes > PROGRAM_CACHE_BYTES) return NULL;
+    
+    while(programCacheBytes.load(std::memory_order_relaxed) + bytes > PROGRAM_CACHE_BYTES ||
+          ESP.getFreeHeap() < PROGRAM_CACHE_HEAP_FLOOR + bytes) {
+        CompiledProgram* victim = programVictim();
+        if(!victim) return NULL;
+        dropProgram(*victim);
+    }
+    
+    CompiledProgram* entry = NULL;
+    for(CompiledProgram& candidate : programCache) {
+        if(candidate.revision == 0) {
+            entry = &candidate;
+            break;
+        }
+    }
+    if(!entry && (entry = programVictim()) != NULL) dropProgram(*entry);
+    if(!entry) return NULL;
+    
+    // Internal RAM: the RMT interrupt copies from it while flash may be busy
+    rmt_data_t* program = (rmt_data_t*)heap_caps_malloc(bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if(!program) return NULL;
+    memcpy(program, compiled.program, bytes);
+    
+    *entry = compiled;
+    entry->program = program;
+    entry->users = 0;
+    programCacheBytes.fetch_add(bytes, std::memory_order_relaxed);
+    return entry;
+}
+
+// Start sending a program; returns at once. False if the channel is busy or down.
+bool startTransmit(SignalType type, const SignalSummary& signal, CompiledProgram& program) {
+    Transmitter& tx = transmitters[type];
+    if(!tx.ready || tx.active) return false;
+    
+    if(signal.carrierHz != tx.carrierHz || signal.carrierDuty != tx.carrierDuty) {
+        if(!rmtSetCarrier(tx.pin, signal.carrierHz != 0, HIGH, signal.carrierHz, signal.carrierDuty / 100.0f)) {
+            return false;
+        }
+        tx.carrierHz = signal.carrierHz;
+        tx.carrierDuty = signal.carrierDuty;
+    }
+    
+    if(!rmtWriteAsync(tx.pin, program.program, program.symbols)) return false;
+    
+    tx.active = true;
+    tx.sending = &program;
+    program.users++;
+    tx.signalNumber = signal.number;
+    tx.endsAt = millis() + program.durationUs / 1000 + 1;
+    return true;
+}
+
+void releaseProgram(Transmitter& tx) {
+    if(tx.sending) tx.sending->users--;
+    tx.sending = NULL;
+    tx.active = false;
+}
+
+// True once the frame in flight has gone out
+bool transmitCompleted(SignalType type) {
+    Transmitter& tx = transmitters[type];
+    if(tx.active && rmtTransmitCompleted(tx.pin)) releaseProgram(tx);
+    return !tx.active;
+}
+
+// Cut the frame in flight short. Tearing the channel down stops it
+// mid-symbol; the rebuilt channel idles LOW.
+void abortTransmit(SignalType type) {
+    Transmitter& tx = transmitters[type];
+    rmtDeinit(tx.pin);
+    releaseProgram(tx);
+    beginTransmitter(type, tx.pin);
+}
+
+// Generate unique signal ID
+uint32_t generateSignalId(char* buffer, size_t size, SignalType type) {
+    const char* prefix = (type == SIGNAL_TYPE_IR) ? "IR" : "RF";
+    uint32_t number = signalCounter.fetch_add(1, std::memory_order_relaxed);
+    snprintf(buffer, size, "%s_%lu", prefix, (unsigned long)number);
+    return number;
+}
+
+// ============================================================================
+// IR CAPTURE AND REPLAY FUNCTIONS
+// ============================================================================
+
+#if ENABLE_IR_MODULE
+
+/*
+ * IR Signal Capture
+ * 
+ * VULNERABILITY DEMONSTRATED:
+ * Most consumer IR remotes use simple pulse-width modulation without
+ * authentication. This allows trivial replay attacks.
+ * 
+ * WHY THIS WORKS ON INSECURE SYSTEMS:
+ * - No rolling codes
+ * - No encryption
+ * - No timestamp validation
+ * - Device accepts any valid timing pattern
+ * 
+ * SECURE ALTERNATIVES:
+ * - Challenge-response authentication
+ * - Time-based one-time codes
+ * - Encrypted command payloads
+ */
+
+/*
+ * IR carrier defaults
+ *
+ * The receiver demodulates, so a capture holds only the envelope and the
+ * carrier is lost. The leader pulse identifies the common protocol
+ * families, and with them the carrier their remotes use. RC-5 has no
+ * leader but is built from 889 us half-bits. Anything else gets
+ * IR_CARRIER_DEFAULT_HZ; POST /api/signal/{id}/carrier corrects it.
+ */
+struct IRLeader {
+    uint16_t mark;          // us
+    uint16_t space;         // us, 0 = any
+    uint32_t carrierHz;
+};
+
+const IRLeader IR_LEADERS[] = {
+    {9000, 4500, 38000},    // NEC and its extended forms
+    {4500, 4500, 38000},    // Samsung
+    {3456, 1728, 36700},    // Kaseikyo (Panasonic, Denon)
+    {2666,  889, 36000},    // RC-6
+    {2400,    0, 40000},    // Sony SIRC
+};
+
+// Within 25%, the usual tolerance of IR decoders
+inline bool timingMatches(uint16_t measured, uint16_t expected) {
+    return measured * 4 >= expected * 3 && measured * 4 <= expected * 5;
+}
+
+uint32_t guessIRCarrier(const RawSignal& signal) {
+    if(signal.length < 2) return IR_CARRIER_DEFAULT_HZ;
+    
+    for(const IRLeader& leader : IR_LEADERS) {
+        if(timingMatches(signal.timings[0], leader.mark) &&
+           (leader.space == 0 || timingMatches(signal.timings[1], leader.space))) {
+            return leader.carrierHz;
+        }
+    }
+    
+    if((timingMatches(signal.timings[0], 889) || timingMatches(signal.timings[0], 1778)) &&
+       (timingMatches(signal.timings[1], 889) || timingMatches(signal.timings[1], 1778))) {
+        return 36000;       // RC-5
+    }
+    
+    return IR_CARRIER_DEFAULT_HZ;
+}
+
+/*
+ * Start of an IR frame
+ *
+ * The receiver idles HIGH and a frame starts with a falling edge. Rather
+ * than spin until one comes, a capture flow arms this interrupt and waits
+ * for irFrameStarted(); the handler stamps the edge and wakes the signal
+ * task, and captureIRSignal() times the frame from that stamp.
+ * irFramePending tells the signal task not to start blocking work that
+ * would keep the flow from timing the frame once it has started.
+ */
+std::atomic<bool> irStartArmed(false);
+std::atomic<bool> irStartSeen(false);
+std::atomic<unsigned long> irStartUs(0);
+bool irFramePending = false;                  // Signal task only
+
+void IRAM_ATTR onIRFrameStart() {
+    if(!irStartArmed.exchange(false)) return;
+    irStartUs = micros();
+    irStartSeen = true;
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(signalTaskHandle, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+// A frame already under way counts as started now
+void armIRFrameStart() {
+    irFramePending = true;
+    irStartSeen = false;
+    irStartArmed = true;
+    if(digitalRead(IR_RECV_PIN) == LOW && irStartArmed.exchange(false)) {
+        irStartUs = micros();
+        irStartSeen = true;
+    }
+}
+
+void disarmIRFrameStart() {
+    irStartArmed = false;
+    irFramePending = false;
+}
+
+bool irFrameStarted(uintptr_t) {
+    return irStartSeen.load();
+}
+
+/*
+ * Time a frame that started (went LOW) at startUs. A self-test echo
+ * (echo true) is not a capture: it takes no signal number and stays out
+ * of the activity log and the capture metrics.
+ */
+bool captureIRSignal(RawSignal& signal, const std::atomic<bool>& cancel, unsigned long startUs, bool echo = false) {
+    const unsigned long timeout = 150000; // 150ms of silence ends the frame
+    const unsigned int minPulse = 50;     // Minimum pulse width (microseconds)
+    const unsigned int maxPulse = 15000;  // Maximum pulse width
+    
+    signal.type = SIGNAL_TYPE_IR;
+    signal.length = 0;
+    signal.timestamp = millis();
+    signal.number = echo ? 0 : generateSignalId(signal.id, sizeof(signal.id), SIGNAL_TYPE_IR);
+    if(echo) signal.id[0] = '\0';
+    
+    int currentState = LOW;
+    int lastState = currentState;
+    unsigned long lastChange = startUs;
+    uint32_t filtered = 0;
+    
+    if(!echo) LOG_EVENT(EVT_IR_CAPTURE_STARTED);
+    
+    // Capture timing data
+    while(signal.length < MAX_SIGNAL_LENGTH) {
+        currentState = digitalRead(IR_RECV_PIN);
+        unsigned long now = micros();
+        
+        if(currentState != lastState) {
+            unsigned long duration = now - lastChange;
+            
+            if(duration >= minPulse && duration <= maxPulse) {
+                signal.timings[signal.length++] = (uint16_t)duration;
+            } else {
+                filtered++;
+                if(!echo) LOG_EVENT(EVT_IR_EDGE_FILTERED, signal.number, (uint16_t)min(duration, 65535UL));
+            }
+            
+            lastChange = now;
+            lastState = currentState;
+        }
+        
+        // End of signal detection (silence)
+        if(now - lastChange > timeout || cancel.load(std::memory_order_relaxed)) {
+            break;
+        }
+    }
+    
+    if(echo) return signal.length > 10;
+    
+    metrics.edgesCaptured.fetch_add(signal.length, std::memory_order_relaxed);
+    metrics.edgesFiltered.fetch_add(filtered, std::memory_order_relaxed);
+    
+    if(signal.length > 10) { // Minimum valid signal length
+        signal.carrierHz = guessIRCarrier(signal);
+        signal.carrierDuty = IR_CARRIER_DEFAULT_DUTY;
+        LOG_EVENT(EVT_IR_CAPTURED, signal.number, signal.length);
+        return true;
+    }
+    
+    LOG_EVENT(EVT_CAPTURE_NO_SIGNAL, signal.number, signal.length);
+    return false;
+}
+
+// Hand the captured timing pattern to the IR transmitter; returns at once
+bool replayIRSignal(const SignalSummary& signal, CompiledProgram& program) {
+    if(signal.type != SIGNAL_TYPE_IR || !startTransmit(SIGNAL_TYPE_IR, signal, program)) return false;
+    
+    LOG_EVENT(EVT_IR_REPLAY_STARTED, signal.number);
+    metrics.replays.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+#endif // ENABLE_IR_MODULE
+
+// ============================================================================
+// RF CAPTURE AND REPLAY FUNCTIONS
+// ============================================================================
+
+#if ENABLE_RF_MODULE
+
+/*
+ * RF 433MHz Signal Capture
+ * 
+ * VULNERABILITY DEMONSTRATED:
+ * Simple fixed-code RF systems transmit the same signal every time.
+ * These are vulnerable to replay attacks.
+ * 
+ * WHY THIS WORKS ON INSECURE SYSTEMS:
+ * - Static codes (same every press)
+ * - No encryption
+ * - No authentication handshake
+ * - Receiver accepts any matching code
+ * 
+ * SYSTEMS THIS DOES NOT AFFECT:
+ * - Rolling code systems (KeeLoq, etc.)
+ * - Encrypted RF protocols
+ * - Challenge-response systems
+ * - Modern car key fobs with crypto
+ * 
+ * SECURE ALTERNATIVES:
+ * - Rolling code algorithms
+ * - AES encryption
+ * - Frequency hopping
+ * - Authentication protocols
+ */
+
+// A self-test echo (echo true) is kept out of IDs, log and metrics as for IR
+bool captureRFSignal(RawSignal& signal, const std::atomic<bool>& cancel, bool echo = false) {
+    const unsigned long timeout = 500000; // 500ms timeout
+    const unsigned int minPulse = 100;
+    const unsigned int maxPulse = 20000;
+    
+    signal.type = SIGNAL_TYPE_RF;
+    signal.length = 0;
+    signal.timestamp = millis();
+    signal.number = echo ? 0 : generateSignalId(signal.id, sizeof(signal.id), SIGNAL_TYPE_RF);
+    if(echo) signal.id[0] = '\0';
+    
+    unsigned long startTime = micros();
+    int currentState = digitalRead(RF_RECV_PIN);
+    int lastState = currentState;
+    unsigned long lastChange = startTime;
+    uint32_t filtered = 0;
+    
+    // Wait for signal activity
+    while(micros() - startTime < timeout && !cancel.load(std::memory_order_relaxed)) {
+        currentState = digitalRead(RF_RECV_PIN);
+        
+        if(currentState != lastState) {
+            unsigned long now = micros();
+            unsigned long duration = now - lastChange;
+            
+            if(duration >= minPulse && duration <= maxPulse) {
                 signal.timings[signal.length++] = (uint16_t)duration;
                 
                 if(signal.length >= MAX_SIGNAL_LENGTH) {
                     break;
                 }
+            } else if(signal.length > 0) {
+                filtered++;
+                if(!echo) LOG_EVENT(EVT_RF_EDGE_FILTERED, signal.number, (uint16_t)min(duration, 65535UL));
             }
             
             lastChange = now;
@@ -315,411 +1390,2205 @@ bool captureRFSignal(RawSignal& signal) {
         }
     }
     
-    if(signal.length > 20) { // Minimum valid RF signal
-        char logMsg[64];
-        snprintf(logMsg, sizeof(logMsg), "RF signal captured: %s (%d timings)", 
-                 signal.id, signal.length);
-        addActivityLog(logMsg);
-        return true;
+    if(echo) return signal.length > 20;
+    
+    metrics.edgesCaptured.fetch_add(signal.length, std::memory_order_relaxed);
+    metrics.edgesFiltered.fetch_add(filtered, std::memory_order_relaxed);
+    
+    if(signal.length > 20) { // Minimum valid RF signal
+        signal.carrierHz = 0;   // The transmitter module does its own OOK
+        signal.carrierDuty = 0;
+        LOG_EVENT(EVT_RF_CAPTURED, signal.number, signal.length);
+        return true;
+    }
+    
+    LOG_EVENT(EVT_CAPTURE_NO_SIGNAL, signal.number, signal.length);
+    return false;
+}
+
+// Hand the captured RF pattern to the RF transmitter; returns at once
+bool replayRFSignal(const SignalSummary& signal, CompiledProgram& program) {
+    if(signal.type != SIGNAL_TYPE_RF || !startTransmit(SIGNAL_TYPE_RF, signal, program)) return false;
+    
+    LOG_EVENT(EVT_RF_REPLAY_STARTED, signal.number);
+    metrics.replays.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+#endif // ENABLE_RF_MODULE
+
+// ============================================================================
+// SIGNAL STORE
+// ============================================================================
+
+/*
+ * Signal store concurrency
+ *
+ * The signal task writes captures and the web task writes signal
+ * settings; both serialize on storeWriteMutex. Readers (the web task,
+ * loop() and the signal task itself) take no lock, and a writer never
+ * waits on a reader however many there are:
+ *
+ * - Metadata (summaries, indexes, payload buffer of each slot) is a
+ *   seqlock. The writer edits storeDraft and copies it word by word into
+ *   storeMetaWords between two increments of storeSequence. Readers copy
+ *   the words out and retry if the sequence was odd or moved meanwhile;
+ *   the copy is under a kilobyte, so a retry costs microseconds.
+ * - Timings live in signalPayloads, STORE_SPARE_PAYLOADS more buffers
+ *   than the store holds. A new signal is written into a free buffer,
+ *   word by word like the metadata, before its metadata is published.
+ *   The evicted signal's buffer is retired with the current storeEpoch
+ *   and reused once every reader pinned at that epoch or earlier has
+ *   unpinned (epoch-based reclamation). Readers stay pinned for one
+ *   metadata and timings copy.
+ * - Should a reader stall across more captures than there are spares,
+ *   the writer reuses the oldest retired buffer anyway. Its generation
+ *   then no longer matches the reader's metadata and the copy is reported
+ *   as not found, which is true: that signal was evicted.
+ */
+
+// Writer: make storeDraft visible to readers
+void publishStoreMeta() {
+    uint32_t sequence = storeSequence.load(std::memory_order_relaxed);
+    storeSequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    
+    for(size_t i = 0; i < STORE_META_WORDS; i++) {
+        uint32_t word;
+        memcpy(&word, (const uint8_t*)&storeDraft + i * 4, 4);
+        storeMetaWords[i].store(word, std::memory_order_relaxed);
+    }
+    
+    storeSequence.store(sequence + 2, std::memory_order_release);
+}
+
+// Reader: consistent copy of the published metadata
+void readStoreMeta(SignalStoreMeta& out) {
+    for(;;) {
+        uint32_t sequence = storeSequence.load(std::memory_order_acquire);
+        if(sequence & 1) continue;
+        
+        for(size_t i = 0; i < STORE_META_WORDS; i++) {
+            uint32_t word = storeMetaWords[i].load(std::memory_order_relaxed);
+            memcpy((uint8_t*)&out + i * 4, &word, 4);
+        }
+        
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if(storeSequence.load(std::memory_order_relaxed) == sequence) return;
+    }
+}
+
+// Reader: announce a timings copy; returns the slot to pass to unpinStore()
+int pinStore() {
+    for(;;) {
+        for(int slot = 0; slot < STORE_READER_SLOTS; slot++) {
+            uint32_t idle = 0;
+            if(storeReaderEpochs[slot].compare_exchange_strong(idle, storeEpoch.load())) {
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                return slot;
+            }
+        }
+    }
+}
+
+void unpinStore(int slot) {
+    storeReaderEpochs[slot].store(0, std::memory_order_release);
+}
+
+// Writer: free retired buffers that no pinned reader can still be copying
+void reclaimPayloads() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    uint32_t oldest = UINT32_MAX;
+    for(int slot = 0; slot < STORE_READER_SLOTS; slot++) {
+        uint32_t epoch = storeReaderEpochs[slot].load();
+        if(epoch != 0 && epoch < oldest) oldest = epoch;
+    }
+    
+    size_t kept = 0;
+    for(size_t i = 0; i < retiredPayloadCount; i++) {
+        if(retiredPayloads[i].epoch < oldest) freePayloads[freePayloadCount++] = retiredPayloads[i].payload;
+        else retiredPayloads[kept++] = retiredPayloads[i];
+    }
+    retiredPayloadCount = kept;
+}
+
+// Writer: a buffer for the next signal's timings; never waits
+uint8_t takePayload() {
+    reclaimPayloads();
+    if(freePayloadCount > 0) return freePayloads[--freePayloadCount];
+    
+    uint8_t payload = retiredPayloads[0].payload;
+    retiredPayloadCount--;
+    memmove(retiredPayloads, retiredPayloads + 1, retiredPayloadCount * sizeof(RetiredPayload));
+    return payload;
+}
+
+void storeBegin() {
+    for(size_t i = 0; i < STORE_PAYLOAD_COUNT; i++) {
+        freePayloads[i] = STORE_PAYLOAD_COUNT - 1 - i;
+    }
+    freePayloadCount = STORE_PAYLOAD_COUNT;
+    publishStoreMeta();
+}
+
+// Store slot at an ordinal position (0 = oldest) of an index
+inline uint16_t indexSlot(const SignalIndex& index, size_t ordinal) {
+    return index.slots[(index.head + ordinal) % MAX_STORED_SIGNALS];
+}
+
+void indexPush(SignalIndex& index, uint16_t slot) {
+    index.slots[(index.head + index.count) % MAX_STORED_SIGNALS] = slot;
+    index.count++;
+}
+
+void indexPopFront(SignalIndex& index) {
+    index.head = (index.head + 1) % MAX_STORED_SIGNALS;
+    index.count--;
+}
+
+// First ordinal whose signal was captured at or after timestamp
+size_t indexLowerBound(const SignalStoreMeta& meta, const SignalIndex& index, unsigned long timestamp) {
+    size_t low = 0, high = index.count;
+    while(low < high) {
+        size_t mid = (low + high) / 2;
+        if(meta.signals[indexSlot(index, mid)].timestamp < timestamp) low = mid + 1;
+        else high = mid;
+    }
+    return low;
+}
+
+void summarizeSignal(const RawSignal& signal, SignalSummary& summary) {
+    summary.type = signal.type;
+    summary.timestamp = signal.timestamp;
+    summary.length = signal.length;
+    summary.number = signal.number;
+    summary.revision = signal.revision;
+    summary.changed = signal.revision;
+    summary.carrierHz = signal.carrierHz;
+    summary.carrierDuty = signal.carrierDuty;
+    memcpy(summary.id, signal.id, sizeof(summary.id));
+}
+
+// Add a captured signal to the store, evicting the oldest when full
+void storeSignal(RawSignal& signal) {
+    SignalStoreMeta& meta = storeDraft;
+    xSemaphoreTake(storeWriteMutex, portMAX_DELAY);
+    
+    uint8_t payload = takePayload();
+    SignalPayload& target = signalPayloads[payload];
+    uint32_t generation = target.generation.load(std::memory_order_relaxed) + 1;
+    target.generation.store(generation, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for(size_t i = 0; i < (signal.length + 1u) / 2; i++) {
+        uint32_t word;
+        memcpy(&word, signal.timings + i * 2, 4);
+        target.words[i].store(word, std::memory_order_relaxed);
+    }
+    
+    uint16_t slot;
+    bool evicted = meta.byTime.count == MAX_STORED_SIGNALS;
+    uint8_t evictedPayload = 0;
+    if(evicted) {
+        slot = indexSlot(meta.byTime, 0);
+        evictedPayload = meta.payloads[slot];
+        forgetProgram(meta.signals[slot].number);
+        LOG_EVENT(EVT_SIGNAL_EVICTED, meta.signals[slot].number);
+        indexPopFront(meta.byType[meta.signals[slot].type]);
+        indexPopFront(meta.byTime);
+    } else {
+        slot = (meta.byTime.head + meta.byTime.count) % MAX_STORED_SIGNALS;
+    }
+    
+    signal.revision = statusRevision.fetch_add(1, std::memory_order_relaxed) + 1;
+    summarizeSignal(signal, meta.signals[slot]);
+    meta.generations[slot] = generation;
+    meta.payloads[slot] = payload;
+    indexPush(meta.byTime, slot);
+    indexPush(meta.byType[signal.type], slot);
+    publishStoreMeta();
+    
+    // After publishing, so a reader never sees a revision newer than the data
+    signalsRevision.store(signal.revision, std::memory_order_release);
+    
+    if(evicted) {
+        retiredPayloads[retiredPayloadCount++] = RetiredPayload{evictedPayload, storeEpoch.fetch_add(1)};
+    }
+    xSemaphoreGive(storeWriteMutex);
+    
+    LOG_EVENT(EVT_SIGNAL_STORED, signal.number, signal.length);
+}
+
+// Ordinal of a signal given by id (or by ordinal when id is NULL), or -1
+int findStoredSignal(const SignalStoreMeta& meta, const char* id, int index) {
+    if(id) {
+        // Signal numbers rise with capture order, so search by number
+        const char* separator = strchr(id, '_');
+        uint32_t number = separator ? strtoul(separator + 1, NULL, 10) : 0;
+        size_t low = 0, high = meta.byTime.count;
+        while(low < high) {
+            size_t mid = (low + high) / 2;
+            if(meta.signals[indexSlot(meta.byTime, mid)].number < number) low = mid + 1;
+            else high = mid;
+        }
+        index = (low < meta.byTime.count && strcmp(meta.signals[indexSlot(meta.byTime, low)].id, id) == 0) ? (int)low : -1;
+    }
+    return (index >= 0 && index < (int)meta.byTime.count) ? index : -1;
+}
+
+// Copy a stored signal out by id (or by ordinal, oldest first, when id is NULL)
+bool copyStoredSignal(const char* id, int index, RawSignal& out) {
+    SignalStoreMeta meta;
+    int reader = pinStore();
+    readStoreMeta(meta);
+    
+    index = findStoredSignal(meta, id, index);
+    bool found = index >= 0;
+    if(found) {
+        uint16_t slot = indexSlot(meta.byTime, index);
+        const SignalSummary& summary = meta.signals[slot];
+        const SignalPayload& payload = signalPayloads[meta.payloads[slot]];
+        
+        out.type = summary.type;
+        out.timestamp = summary.timestamp;
+        out.length = summary.length;
+        out.number = summary.number;
+        out.revision = summary.revision;
+        out.carrierHz = summary.carrierHz;
+        out.carrierDuty = summary.carrierDuty;
+        memcpy(out.id, summary.id, sizeof(out.id));
+        for(size_t i = 0; i < (summary.length + 1u) / 2; i++) {
+            uint32_t word = payload.words[i].load(std::memory_order_relaxed);
+            memcpy(out.timings + i * 2, &word, 4);
+        }
+        
+        std::atomic_thread_fence(std::memory_order_acquire);
+        found = payload.generation.load(std::memory_order_relaxed) == meta.generations[slot];
+    }
+    
+    unpinStore(reader);
+    return found;
+}
+
+/*
+ * Change the IR carrier of a stored signal; the next replay uses it.
+ * The signal keeps its revision, which orders signals by capture and tags
+ * the unchanged timings. The change gets a new store revision in changed
+ * and signalsRevision, so listings, status polls and the event stream all
+ * see it. Returns false for an unknown id.
+ */
+bool setSignalCarrier(const char* id, uint32_t carrierHz, uint8_t carrierDuty) {
+    xSemaphoreTake(storeWriteMutex, portMAX_DELAY);
+    int index = findStoredSignal(storeDraft, id, -1);
+    if(index >= 0) {
+        SignalSummary& summary = storeDraft.signals[indexSlot(storeDraft.byTime, index)];
+        summary.carrierHz = carrierHz;
+        summary.carrierDuty = carrierDuty;
+        summary.changed = statusRevision.fetch_add(1, std::memory_order_relaxed) + 1;
+        publishStoreMeta();
+        signalsRevision.store(summary.changed, std::memory_order_release);
+    }
+    xSemaphoreGive(storeWriteMutex);
+    return index >= 0;
+}
+
+// Metadata of a stored signal by id (or by ordinal when id is NULL), and
+// optionally the store slot it occupies for as long as it is stored
+bool findSignalSummary(const char* id, int index, SignalSummary& out, uint16_t* slot = NULL) {
+    SignalStoreMeta meta;
+    readStoreMeta(meta);
+    index = findStoredSignal(meta, id, index);
+    if(index >= 0) {
+        uint16_t found = indexSlot(meta.byTime, index);
+        out = meta.signals[found];
+        if(slot) *slot = found;
+    }
+    return index >= 0;
+}
+
+size_t storedSignalCount() {
+    SignalStoreMeta meta;
+    readStoreMeta(meta);
+    return meta.byTime.count;
+}
+
+// Copy metadata of signals stored or changed after revision since, in
+// the order the changes happened
+size_t snapshotSignals(uint32_t since, SignalSummary* out) {
+    SignalStoreMeta meta;
+    readStoreMeta(meta);
+    
+    size_t count = 0;
+    for(size_t i = 0; i < meta.byTime.count; i++) {
+        const SignalSummary& summary = meta.signals[indexSlot(meta.byTime, i)];
+        if(summary.changed <= since) continue;
+        
+        // Captures arrive in order already; only carrier edits move back
+        size_t at = count++;
+        while(at > 0 && out[at - 1].changed > summary.changed) {
+            out[at] = out[at - 1];
+            at--;
+        }
+        out[at] = summary;
+    }
+    
+    return count;
+}
+
+/*
+ * Signal query
+ *
+ * Selects the type index (or the full one), narrows it to [from, to] by
+ * binary search on capture time and copies one page in the requested
+ * order, so the work is O(log n + limit) whatever the store size.
+ * Returns the number of matching signals; count receives the page size.
+ */
+size_t querySignals(int type, unsigned long from, unsigned long to, bool descending,
+                    size_t offset, size_t limit, SignalSummary* out, size_t& count) {
+    SignalStoreMeta meta;
+    readStoreMeta(meta);
+    
+    const SignalIndex& index = type < 0 ? meta.byTime : meta.byType[type];
+    size_t begin = indexLowerBound(meta, index, from);
+    size_t end = (to == ULONG_MAX) ? index.count : indexLowerBound(meta, index, to + 1);
+    size_t total = end > begin ? end - begin : 0;
+    
+    count = 0;
+    for(size_t i = offset; i < total && count < limit; i++) {
+        size_t ordinal = descending ? end - 1 - i : begin + i;
+        out[count++] = meta.signals[indexSlot(index, ordinal)];
+    }
+    
+    return total;
+}
+
+// ============================================================================
+// REPLAY SELF-TEST
+// ============================================================================
+
+/*
+ * Replay self-test
+ *
+ * With a send pin looped back to its receiver (a wire for RF, the LED
+ * facing the IR receiver), a stored signal is replayed while the signal
+ * task captures it, and the echo is graded edge by edge against the
+ * stored timings. The first edge is not graded: the frame starts as the
+ * capture loop does, so its leading edge is not timed exactly.
+ *
+ * Receivers may add or swallow an edge at the start of a frame, and RF
+ * captures record the idle time before the first edge, so the echo is
+ * aligned by trying offsets up to SELFTEST_MAX_SHIFT either way. The
+ * offset with the most edges within tolerance wins, then the one with
+ * the smaller total error. Tolerance is SELFTEST_TOLERANCE_US or
+ * SELFTEST_TOLERANCE_PERCENT of the edge, whichever is larger. The test
+ * passes when every graded edge has an echo within tolerance. Mean mark
+ * and space errors are reported apart because receivers stretch one at
+ * the expense of the other.
+ */
+
+inline uint32_t selfTestTolerance(uint16_t timing) {
+    return max((uint32_t)SELFTEST_TOLERANCE_US, (uint32_t)timing * SELFTEST_TOLERANCE_PERCENT / 100);
+}
+
+void gradeSelfTest(const RawSignal& reference, const RawSignal& echo, SelfTestResult& result) {
+    int bestShift = 0;
+    int bestMatched = -1;
+    uint32_t bestError = 0;
+    for(int shift = -SELFTEST_MAX_SHIFT; shift <= SELFTEST_MAX_SHIFT; shift++) {
+        int matched = 0;
+        uint32_t error = 0;
+        for(int i = 1; i < reference.length; i++) {
+            int j = i + shift;
+            if(j < 0 || j >= echo.length) continue;
+            uint32_t magnitude = abs((int32_t)echo.timings[j] - (int32_t)reference.timings[i]);
+            if(magnitude <= selfTestTolerance(reference.timings[i])) matched++;
+            error += magnitude;
+        }
+        if(matched > bestMatched || (matched == bestMatched && error < bestError)) {
+            bestShift = shift;
+            bestMatched = matched;
+            bestError = error;
+        }
+    }
+    
+    result = SelfTestResult();
+    result.shift = bestShift;
+    int64_t markSum = 0, spaceSum = 0;
+    uint32_t marks = 0, spaces = 0;
+    uint64_t absSum = 0;
+    
+    for(int i = 1; i < reference.length; i++) {
+        int j = i + bestShift;
+        if(j < 0 || j >= echo.length) {
+            result.missing++;
+            continue;
+        }
+        
+        int32_t error = (int32_t)echo.timings[j] - (int32_t)reference.timings[i];
+        uint32_t magnitude = abs(error);
+        result.edges++;
+        absSum += magnitude;
+        if(i % 2 == 0) {
+            markSum += error;
+            marks++;
+        } else {
+            spaceSum += error;
+            spaces++;
+        }
+        if(magnitude > selfTestTolerance(reference.timings[i])) result.outliers++;
+        if(magnitude > result.maxAbsErrorUs) {
+            result.maxAbsErrorUs = magnitude;
+            result.worstEdge = i;
+        }
+    }
+    
+    result.extra = max(echo.length - (reference.length + bestShift), 0);
+    result.markErrorUs = marks ? markSum / marks : 0;
+    result.spaceErrorUs = spaces ? spaceSum / spaces : 0;
+    result.meanAbsErrorUs = result.edges ? absSum / result.edges : 0;
+    result.passed = result.edges > 0 && result.missing == 0 && result.outliers == 0;
+}
+
+// ============================================================================
+// OUTPUT CALIBRATION
+// ============================================================================
+
+/*
+ * Output calibration
+ *
+ * The path from the send pin to the receiver is not neutral: driver and
+ * LED rise and fall times and the receivers' AGC stretch marks and
+ * shorten spaces by a roughly fixed amount, and differently on the IR and
+ * RF paths. Each transmitter keeps a mark and a space trim that
+ * compileRmtProgram() adds to every edge it sends.
+ *
+ * A calibration run is a loopback self-test whose median mark and space
+ * errors are subtracted from the trims. The trims therefore correct the
+ * whole bench path, the loopback receiver included. The echo already
+ * carries the current trims, so a run corrects what is left and repeated
+ * runs converge. Edges off by more than CALIBRATION_MAX_TRIM_US are a lost
+ * or split edge rather than latency and are left out; the median keeps a
+ * few glitches from moving the trims. A run needs CALIBRATION_MIN_EDGES
+ * marks and as many spaces. Trims are kept in NVS and loaded at boot.
+ *
+ * A change bumps the transmitter's calibration count, which is part of
+ * the program cache key, so programs built with the old trims are not
+ * sent again. Trims are written by the signal task only.
+ */
+
+const char* const CALIBRATION_KEYS[2][2] = {{"irMark", "irSpace"}, {"rfMark", "rfSpace"}};
+
+void loadCalibration() {
+    Preferences preferences;
+    if(!preferences.begin(CALIBRATION_NAMESPACE, true)) return;     // Never calibrated
+    for(int type = 0; type < 2; type++) {
+        transmitters[type].markTrimUs = preferences.getShort(CALIBRATION_KEYS[type][0], 0);
+        transmitters[type].spaceTrimUs = preferences.getShort(CALIBRATION_KEYS[type][1], 0);
+    }
+    preferences.end();
+}
+
+inline int16_t clampTrim(int32_t trimUs) {
+    return min(max(trimUs, (int32_t)-CALIBRATION_MAX_TRIM_US), (int32_t)CALIBRATION_MAX_TRIM_US);
+}
+
+/*
+ * Fold a graded echo into the trims and report the trims now in effect;
+ * false if too few edges were usable
+ */
+bool applyCalibration(SignalType type, const RawSignal& reference, const RawSignal& echo,
+                      const SelfTestResult& result, int16_t& markTrimUs, int16_t& spaceTrimUs) {
+    static int16_t errors[2][MAX_SIGNAL_LENGTH / 2 + 1];    // Marks, spaces
+    uint16_t counts[2] = {0, 0};
+    for(int i = 1; i < reference.length; i++) {
+        int j = i + result.shift;
+        if(j < 0 || j >= echo.length) continue;
+        int32_t error = (int32_t)echo.timings[j] - (int32_t)reference.timings[i];
+        if(abs(error) > CALIBRATION_MAX_TRIM_US) continue;
+        errors[i % 2][counts[i % 2]++] = error;
+    }
+    if(counts[0] < CALIBRATION_MIN_EDGES || counts[1] < CALIBRATION_MIN_EDGES) return false;
+    
+    int16_t medians[2];
+    for(int kind = 0; kind < 2; kind++) {
+        std::nth_element(errors[kind], errors[kind] + counts[kind] / 2, errors[kind] + counts[kind]);
+        medians[kind] = errors[kind][counts[kind] / 2];
+    }
+    
+    Transmitter& tx = transmitters[type];
+    int16_t markTrim = clampTrim(tx.markTrimUs - medians[0]);
+    int16_t spaceTrim = clampTrim(tx.spaceTrimUs - medians[1]);
+    markTrimUs = markTrim;
+    spaceTrimUs = spaceTrim;
+    if(markTrim == tx.markTrimUs && spaceTrim == tx.spaceTrimUs) return true;
+    
+    tx.markTrimUs = markTrim;
+    tx.spaceTrimUs = spaceTrim;
+    tx.calibration++;
+    
+    Preferences preferences;
+    if(preferences.begin(CALIBRATION_NAMESPACE, false)) {
+        preferences.putShort(CALIBRATION_KEYS[type][0], markTrim);
+        preferences.putShort(CALIBRATION_KEYS[type][1], spaceTrim);
+        preferences.end();
+    }
+    return true;
+}
+
+// ============================================================================
+// COROUTINE FLOWS
+// ============================================================================
+
+/*
+ * Coroutine flows
+ *
+ * Hardware work that waits between steps (a replay waiting for its frame
+ * to go out, a capture waiting for a frame to start, the attack
+ * simulation pausing between replays) is written as a C++20 coroutine, a
+ * Flow, instead of state kept in globals from one task wakeup to the
+ * next. Each wait is a co_await: the flow is suspended and other flows
+ * on the same task run until it is due. A FlowExecutor belongs to one
+ * task (the signal task and loop() each have one) and is only touched
+ * from it; run() resumes the flows whose wait is over and returns how
+ * long the task may sleep.
+ *
+ * A wait ends when its condition holds, at its timeout, or when the flow
+ * is cancelled, and co_await says which (FlowWake). Cancellation is
+ * checked at every suspension point: the slot's own flag, set by
+ * cancel(), or an external one such as a job's cancelRequested, which
+ * other tasks set before notifying the owner. A cancelled flow cleans up
+ * and co_returns; each further wait ends at once with FLOW_CANCELLED.
+ *
+ * Conditions are plain functions, checked whenever the owner runs the
+ * executor; waits whose condition nothing notifies also poll it every
+ * pollMs from pollAfterMs on. Steps between waits run to completion, so
+ * the microsecond edge loops of a capture stay busy-waits inside one
+ * step and hold up the other flows of their task while they run.
+ *
+ * Frames are allocated from internal RAM without exceptions; when one
+ * cannot be had the coroutine is never created and spawn() fails.
+ */
+
+enum FlowWake : uint8_t {
+    FLOW_READY,         // Condition met, or the delay is over
+    FLOW_TIMEOUT,       // Timed out with the condition still false
+    FLOW_CANCELLED
+};
+
+#define FLOW_FOREVER UINT32_MAX     // Timeout of a wait only its condition or a cancel ends
+
+typedef bool (*FlowCondition)(uintptr_t arg);
+
+struct FlowSlot;
+
+struct Flow {
+    struct promise_type {
+        FlowSlot* slot = NULL;
+        
+        Flow get_return_object() { return Flow(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        static Flow get_return_object_on_allocation_failure() { return Flow(nullptr); }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { abort(); }
+        
+        static void* operator new(size_t size) noexcept {
+            return heap_caps_malloc(size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        }
+        static void operator delete(void* frame) { heap_caps_free(frame); }
+    };
+    
+    explicit Flow(std::coroutine_handle<promise_type> handle) : handle(handle) {}
+    std::coroutine_handle<promise_type> handle;     // Owned by the executor once spawned
+};
+
+// Executor slot of one flow and the wait it is suspended in
+struct FlowSlot {
+    std::coroutine_handle<Flow::promise_type> handle;  // NULL = free
+    uint32_t id;
+    const std::atomic<bool>* cancelFlag;    // External cancel request, or NULL
+    bool cancelled;                         // cancel() was called
+    FlowCondition condition;                // NULL = plain delay
+    uintptr_t conditionArg;
+    bool timed;                             // The wait has a timeout
+    unsigned long timeoutAt;                // millis()
+    unsigned long pollAt;                   // millis() of the next condition poll
+    uint32_t pollMs;                        // 0 = checked only when the task wakes
+    FlowWake wake;                          // How the last wait ended
+};
+
+// co_await flowDelay(...) or flowUntil(...)
+struct FlowWait {
+    FlowCondition condition;
+    uintptr_t arg;
+    uint32_t timeoutMs;
+    uint32_t pollAfterMs;
+    uint32_t pollMs;
+    FlowSlot* slot;
+    
+    bool await_ready() const { return false; }
+    
+    void await_suspend(std::coroutine_handle<Flow::promise_type> handle) {
+        unsigned long now = millis();
+        slot = handle.promise().slot;
+        slot->condition = condition;
+        slot->conditionArg = arg;
+        slot->timed = timeoutMs != FLOW_FOREVER;
+        slot->timeoutAt = now + timeoutMs;
+        slot->pollAt = now + pollAfterMs;
+        slot->pollMs = pollMs;
+    }
+    
+    FlowWake await_resume() const { return slot->wake; }
+};
+
+inline FlowWait flowDelay(uint32_t ms) {
+    return FlowWait{NULL, 0, ms, 0, 0, NULL};
+}
+
+inline FlowWait flowUntil(FlowCondition condition, uintptr_t arg, uint32_t timeoutMs,
+                          uint32_t pollAfterMs = 0, uint32_t pollMs = 0) {
+    return FlowWait{condition, arg, timeoutMs, pollAfterMs, pollMs, NULL};
+}
+
+class FlowExecutor {
+public:
+    // Take over a flow; it first runs on the next run(). False if it could
+    // not be created or all slots are taken; id receives its handle.
+    bool spawn(Flow flow, const std::atomic<bool>* cancelFlag = NULL, uint32_t* id = NULL) {
+        if(!flow.handle) return false;
+        for(FlowSlot& slot : slots) {
+            if(slot.handle) continue;
+            slot = FlowSlot();
+            slot.handle = flow.handle;
+            slot.id = nextId++;
+            slot.cancelFlag = cancelFlag;
+            slot.timeoutAt = millis();
+            slot.timed = true;
+            flow.handle.promise().slot = &slot;
+            if(id) *id = slot.id;
+            return true;
+        }
+        flow.handle.destroy();
+        return false;
+    }
+    
+    // Flag a flow cancelled; it sees it on the next run()
+    void cancel(uint32_t id) {
+        FlowSlot* slot = find(id);
+        if(slot) slot->cancelled = true;
+    }
+    
+    bool running(uint32_t id) {
+        return find(id) != NULL;
+    }
+    
+    bool full() const {
+        for(const FlowSlot& slot : slots) {
+            if(!slot.handle) return false;
+        }
+        return true;
+    }
+    
+    // Resume every flow whose wait is over; returns the ms until one is
+    // next due, ULONG_MAX if only a notification can wake one
+    unsigned long run() {
+        unsigned long wait = ULONG_MAX;
+        for(FlowSlot& slot : slots) {
+            if(!slot.handle) continue;
+            
+            unsigned long now = millis();
+            if(due(slot, now)) {
+                slot.handle.resume();
+                if(slot.handle.done()) {
+                    slot.handle.destroy();
+                    slot.handle = nullptr;
+                    continue;
+                }
+                now = millis();
+                if(due(slot, now)) {
+                    wait = 0;           // Over already; resumed on the next run()
+                    continue;
+                }
+            }
+            wait = min(wait, untilDue(slot, now));
+        }
+        return wait;
+    }
+    
+private:
+    FlowSlot* find(uint32_t id) {
+        for(FlowSlot& slot : slots) {
+            if(slot.handle && slot.id == id) return &slot;
+        }
+        return NULL;
+    }
+    
+    // Whether the slot's wait is over; sets how it ended
+    static bool due(FlowSlot& slot, unsigned long now) {
+        if(slot.cancelled || (slot.cancelFlag && slot.cancelFlag->load(std::memory_order_relaxed))) {
+            slot.wake = FLOW_CANCELLED;
+            return true;
+        }
+        if(slot.condition && slot.condition(slot.conditionArg)) {
+            slot.wake = FLOW_READY;
+            return true;
+        }
+        if(slot.timed && (long)(now - slot.timeoutAt) >= 0) {
+            slot.wake = slot.condition ? FLOW_TIMEOUT : FLOW_READY;
+            return true;
+        }
+        return false;
+    }
+    
+    static unsigned long untilDue(FlowSlot& slot, unsigned long now) {
+        unsigned long wait = ULONG_MAX;
+        if(slot.timed) wait = max((long)(slot.timeoutAt - now), 0L);
+        if(slot.condition && slot.pollMs) {
+            long poll = (long)(slot.pollAt - now);
+            if(poll <= 0) {
+                slot.pollAt = now + slot.pollMs;
+                poll = slot.pollMs;
+            }
+            wait = min(wait, (unsigned long)poll);
+        }
+        return wait;
+    }
+    
+    FlowSlot slots[MAX_FLOWS] = {};
+    uint32_t nextId = 1;
+};
+
+FlowExecutor signalFlows;       // Signal task only
+FlowExecutor loopFlows;         // loop() only
+
+// ============================================================================
+// JOB SCHEDULER
+// ============================================================================
+
+/*
+ * Job scheduler
+ *
+ * Every capture and replay is a Job in jobs[]. Web handlers and loop()
+ * submit jobs; the signal task starts them. A job names the pins it needs
+ * (JobResource) and starts only when none are held. Among runnable jobs
+ * the most urgent priority class goes first, then the earliest deadline,
+ * then the oldest. A job whose deadline passes before it can start
+ * expires instead of running late.
+ *
+ * Cancellation is cooperative: a queued job is finished on the spot, and
+ * a running one has cancelRequested set and the signal task woken. The
+ * job's flow sees it at its next wait and the capture loops poll it
+ * alongside their timeouts, so a replay in flight is aborted at once
+ * unless a capture is busy-waiting. Stop requests and
+ * FAILSAFE_TIMEOUT_MS use this path instead of waiting for a frame or a
+ * capture loop to run out. No web handler waits on a job, so a cancel
+ * request is served straight away even while the UI's own replay runs.
+ *
+ * jobsMutex guards slot allocation, status and busyResources. It is never
+ * held across hardware I/O.
+ */
+
+void lockJobs() {
+    xSemaphoreTake(jobsMutex, portMAX_DELAY);
+}
+
+void unlockJobs() {
+    xSemaphoreGive(jobsMutex);
+}
+
+inline bool jobFinished(JobStatus status) {
+    return status >= JOB_DONE;
+}
+
+void setJobStatus(Job& job, JobStatus status) {
+    job.status = status;
+    job.revision = jobsRevision.fetch_add(1, std::memory_order_relaxed) + 1;
+    statusRevision.fetch_add(1, std::memory_order_relaxed);
+}
+
+const char* const JOB_STATUS_NAMES[] = {"queued", "running", "done", "failed", "cancelled", "expired"};
+const char* const JOB_KIND_NAMES[] = {"capture", "replay", "selftest", "calibrate"};
+const char* const JOB_PRIORITY_NAMES[] = {"interactive", "background"};
+
+// Returns the job with this id, or NULL if it was recycled
+Job* findJob(uint32_t id) {
+    Job& job = jobs[id % MAX_JOBS];
+    return (job.id == id && id != 0) ? &job : NULL;
+}
+
+// Caller holds jobsMutex
+void finishJobLocked(Job& job, JobStatus status) {
+    if(job.status == JOB_RUNNING) {
+        busyResources.fetch_and(~job.resources);
+    }
+    setJobStatus(job, status);
+    if(status == JOB_CANCELLED) LOG_EVENT(EVT_JOB_CANCELLED, job.id);
+    if(status == JOB_EXPIRED) LOG_EVENT(EVT_JOB_EXPIRED, job.id);
+    wakeLoopTask();
+}
+
+void finishJob(Job& job, JobStatus status) {
+    lockJobs();
+    finishJobLocked(job, status);
+    unlockJobs();
+}
+
+/*
+ * Queue a job for the signal task. deadlineMs bounds how long it may wait
+ * to start (0 = no limit); signalId names the replay target. Returns NULL
+ * when the slot the job would take still holds an unfinished job.
+ */
+Job* submitJob(JobKind kind, SignalType type, JobPriority priority,
+               unsigned long deadlineMs, const char* signalId) {
+    lockJobs();
+    Job& job = jobs[nextJobId % MAX_JOBS];
+    if(job.id != 0 && !jobFinished(job.status)) {
+        unlockJobs();
+        return NULL;
+    }
+    
+    job.id = nextJobId++;
+    job.kind = kind;
+    job.priority = priority;
+    job.type = type;
+    if(kind == JOB_CAPTURE) job.resources = type == SIGNAL_TYPE_IR ? RESOURCE_IR_RX : RESOURCE_RF_RX;
+    else if(kind == JOB_REPLAY) job.resources = type == SIGNAL_TYPE_IR ? RESOURCE_IR_TX : RESOURCE_RF_TX;
+    else job.resources = type == SIGNAL_TYPE_IR ? RESOURCE_IR_RX | RESOURCE_IR_TX : RESOURCE_RF_RX | RESOURCE_RF_TX;
+    job.startedAt = 0;
+    job.deadline = deadlineMs ? max(millis() + deadlineMs, 1UL) : 0;
+    job.cancelRequested = false;
+    job.signalNumber = 0;
+    job.selfTest = SelfTestResult();
+    strncpy(job.signalId, signalId ? signalId : "", sizeof(job.signalId) - 1);
+    job.signalId[sizeof(job.signalId) - 1] = '\0';
+    setJobStatus(job, JOB_QUEUED);
+    unlockJobs();
+    
+    xTaskNotifyGive(signalTaskHandle);
+    return &job;
+}
+
+// Whether a comes before b: priority class, then deadline, then age
+bool jobBefore(const Job& a, const Job& b) {
+    if(a.priority != b.priority) return a.priority < b.priority;
+    if((a.deadline != 0) != (b.deadline != 0)) return a.deadline != 0;
+    if(a.deadline != b.deadline) return (long)(a.deadline - b.deadline) < 0;
+    return a.id < b.id;
+}
+
+// Claim the most urgent runnable job, expiring overdue ones on the way.
+// Jobs needing a resource in deferred wait as if it were busy.
+Job* startNextJob(uint8_t deferred) {
+    unsigned long now = millis();
+    Job* best = NULL;
+    
+    lockJobs();
+    uint8_t busy = busyResources.load();
+    for(size_t i = 0; i < MAX_JOBS; i++) {
+        Job& job = jobs[i];
+        if(job.id == 0 || job.status != JOB_QUEUED) continue;
+        
+        if(job.deadline != 0 && (long)(now - job.deadline) > 0) {
+            finishJobLocked(job, JOB_EXPIRED);
+            continue;
+        }
+        if(job.resources & (busy | deferred)) continue;
+        if(!best || jobBefore(job, *best)) best = &job;
+    }
+    
+    if(best) {
+        busyResources.fetch_or(best->resources);
+        best->startedAt = now;
+        setJobStatus(*best, JOB_RUNNING);
+        wakeLoopTask();
+    }
+    unlockJobs();
+    
+    return best;
+}
+
+// Caller holds jobsMutex; the job is running
+void requestCancelLocked(Job& job) {
+    job.cancelRequested = true;
+    xTaskNotifyGive(signalTaskHandle);
+}
+
+// Cancel a job by id; false if it is unknown or already finished
+bool cancelJob(uint32_t id) {
+    lockJobs();
+    Job* job = findJob(id);
+    bool active = job && !jobFinished(job->status);
+    if(active) {
+        if(job->status == JOB_QUEUED) finishJobLocked(*job, JOB_CANCELLED);
+        else requestCancelLocked(*job);
+    }
+    unlockJobs();
+    return active;
+}
+
+// Cancel every unfinished job of a priority class
+void cancelJobs(JobPriority priority) {
+    lockJobs();
+    for(size_t i = 0; i < MAX_JOBS; i++) {
+        Job& job = jobs[i];
+        if(job.id == 0 || job.priority != priority || jobFinished(job.status)) continue;
+        if(job.status == JOB_QUEUED) finishJobLocked(job, JOB_CANCELLED);
+        else requestCancelLocked(job);
+    }
+    unlockJobs();
+}
+
+JobStatus jobStatus(uint32_t id) {
+    lockJobs();
+    Job* job = findJob(id);
+    JobStatus status = job ? job->status : JOB_FAILED;
+    unlockJobs();
+    return status;
+}
+
+/*
+ * Cancel jobs that have run longer than FAILSAFE_TIMEOUT_MS. Returns the
+ * ms until the next running job would reach it (ULONG_MAX if none).
+ */
+unsigned long enforceFailsafe(unsigned long now) {
+    unsigned long next = ULONG_MAX;
+    bool tripped = false;
+    
+    lockJobs();
+    for(size_t i = 0; i < MAX_JOBS; i++) {
+        Job& job = jobs[i];
+        if(job.id == 0 || job.status != JOB_RUNNING || job.cancelRequested) continue;
+        
+        // Signed: a job started after now was read has just started
+        long elapsed = max((long)(now - job.startedAt), 0L);
+        if(elapsed > FAILSAFE_TIMEOUT_MS) {
+            requestCancelLocked(job);
+            tripped = true;
+        } else {
+            next = min(next, (unsigned long)(FAILSAFE_TIMEOUT_MS - elapsed + 1));
+        }
+    }
+    unlockJobs();
+    
+    if(tripped) {
+        attackSimulationActive = false;
+        statusRevision.fetch_add(1, std::memory_order_relaxed);
+        LOG_EVENT(EVT_FAILSAFE_TIMEOUT);
+    }
+    return next;
+}
+
+/*
+ * Signal task
+ *
+ * Owns the receiver and transmitter pins and runs the jobs startNextJob()
+ * hands it, so neither the web server nor loop() ever waits on hardware
+ * I/O. Capture busy-waits on the receiver pin, so the task sits alone at
+ * high priority on APP_CPU, away from the WiFi stack.
+ *
+ * Each job runs as a flow on signalFlows (see "Coroutine flows"), with
+ * its cancelRequested as the cancel flag, so a Stop request or the
+ * failsafe ends it at its next wait. A replay starts its frame and waits
+ * for the RMT to send it, holding only its TX resource. An IR capture
+ * waits for the start-of-frame interrupt, then times the frame. A
+ * self-test or calibration run holds the receiver as well and captures
+ * the echo while its frame is sent. While flows wait, other jobs start.
+ *
+ * The working signal buffer is static and shared by the flows, so a flow
+ * never keeps data in it across a co_await.
+ */
+
+// Finish a job and let the web task push the change right away
+void completeJob(Job& job, JobStatus status) {
+    finishJob(job, status);
+    wakeWebTask();
+}
+
+bool transmitIdle(uintptr_t type) {
+    return transmitCompleted((SignalType)type);
+}
+
+// Wait for a transmitter's frame to go out, polling from when it is due
+FlowWait frameSent(SignalType type) {
+    long left = (long)(transmitters[type].endsAt - millis());
+    return flowUntil(transmitIdle, type, FLOW_FOREVER, max(left, 0L), TX_POLL_INTERVAL_MS);
+}
+
+// Account for a finished capture and store it; the job's outcome
+JobStatus storeCapture(Job& job, RawSignal& signal, bool success) {
+    if(job.cancelRequested) return JOB_CANCELLED;
+    
+    metrics.captures.fetch_add(1, std::memory_order_relaxed);
+    (success ? metrics.capturesSucceeded : metrics.capturesFailed).fetch_add(1, std::memory_order_relaxed);
+    
+    if(!success) return JOB_FAILED;
+    
+    storeSignal(signal);
+    job.signalNumber = signal.number;
+    strncpy(job.signalId, signal.id, sizeof(job.signalId));
+    return JOB_DONE;
+}
+
+Flow captureFlow(Job& job, RawSignal& signal) {
+    bool success = false;
+    
+    #if ENABLE_IR_MODULE
+    if(job.type == SIGNAL_TYPE_IR) {
+        armIRFrameStart();
+        if(co_await flowUntil(irFrameStarted, 0, IR_CAPTURE_START_TIMEOUT_MS) == FLOW_READY) {
+            success = captureIRSignal(signal, job.cancelRequested, irStartUs);
+        }
+        disarmIRFrameStart();
+    }
+    #endif
+    #if ENABLE_RF_MODULE
+    if(job.type == SIGNAL_TYPE_RF) success = captureRFSignal(signal, job.cancelRequested);
+    #endif
+    
+    completeJob(job, storeCapture(job, signal, success));
+    co_return;
+}
+
+/*
+ * Program for a stored signal: the cached one, or compiled now from the
+ * timings (copied into signal) and cached if possible. NULL if the
+ * signal is gone.
+ */
+CompiledProgram* loadProgram(Transmitter& tx, const SignalSummary& summary, RawSignal& signal) {
+    programCacheClock++;
+    CompiledProgram* entry = findProgram(summary.number, summary.revision, tx.calibration);
+    if(entry) {
+        metrics.programCacheHits.fetch_add(1, std::memory_order_relaxed);
+        entry->lastUsed = programCacheClock;
+        return entry;
+    }
+    
+    metrics.programCacheMisses.fetch_add(1, std::memory_order_relaxed);
+    if(tx.active || !copyStoredSignal(summary.id, -1, signal) || signal.revision != summary.revision) return NULL;
+    
+    CompiledProgram& scratch = tx.scratch;
+    scratch.number = summary.number;
+    scratch.revision = summary.revision;
+    scratch.calibration = tx.calibration;
+    scratch.lastUsed = programCacheClock;
+    scratch.program = tx.scratchProgram;
+    scratch.symbols = compileRmtProgram(signal, tx, scratch.program, &scratch.durationUs);
+    scratch.users = 0;
+    
+    entry = cacheProgram(scratch);
+    return entry ? entry : &scratch;
+}
+
+// Start the frame of a replay job; false if it could not be sent
+bool startReplayJob(Job& job, RawSignal& signal) {
+    SignalSummary summary;
+    if(!findSignalSummary(job.signalId, -1, summary) || summary.type != job.type) return false;
+    CompiledProgram* program = loadProgram(transmitters[summary.type], summary, signal);
+    if(!program) return false;
+    
+    #if ENABLE_IR_MODULE
+    if(summary.type == SIGNAL_TYPE_IR) return replayIRSignal(summary, *program);
+    #endif
+    #if ENABLE_RF_MODULE
+    if(summary.type == SIGNAL_TYPE_RF) return replayRFSignal(summary, *program);
+    #endif
+    return false;
+}
+
+Flow replayFlow(Job& job, RawSignal& signal) {
+    if(!startReplayJob(job, signal)) {
+        completeJob(job, JOB_FAILED);
+        co_return;
+    }
+    
+    uint32_t number = transmitters[job.type].signalNumber;
+    if(co_await frameSent(job.type) == FLOW_CANCELLED) {
+        abortTransmit(job.type);
+        completeJob(job, JOB_CANCELLED);
+        co_return;
+    }
+    
+    if(job.type == SIGNAL_TYPE_IR) LOG_EVENT(EVT_IR_REPLAYED, number);
+    if(job.type == SIGNAL_TYPE_RF) LOG_EVENT(EVT_RF_REPLAYED, number);
+    completeJob(job, JOB_DONE);
+}
+
+// Replay a stored signal while capturing its echo, then grade the echo
+Flow selfTestFlow(Job& job, RawSignal& reference) {
+    static RawSignal echo;
+    SignalSummary summary;
+    if(!findSignalSummary(job.signalId, -1, summary) || summary.type != job.type ||
+       !copyStoredSignal(job.signalId, -1, reference)) {
+        completeJob(job, JOB_FAILED);
+        co_return;
+    }
+    
+    // Armed before the frame starts so its first edge is not missed
+    #if ENABLE_IR_MODULE
+    if(summary.type == SIGNAL_TYPE_IR) armIRFrameStart();
+    #endif
+    CompiledProgram* program = loadProgram(transmitters[summary.type], summary, reference);
+    bool started = program && startTransmit(summary.type, summary, *program);
+    
+    bool captured = false;
+    #if ENABLE_IR_MODULE
+    if(summary.type == SIGNAL_TYPE_IR) {
+        if(started && co_await flowUntil(irFrameStarted, 0, IR_CAPTURE_START_TIMEOUT_MS) == FLOW_READY) {
+            captured = captureIRSignal(echo, job.cancelRequested, irStartUs, true);
+        }
+        disarmIRFrameStart();
+    }
+    #endif
+    #if ENABLE_RF_MODULE
+    if(summary.type == SIGNAL_TYPE_RF && started) captured = captureRFSignal(echo, job.cancelRequested, true);
+    #endif
+    if(!started) {
+        completeJob(job, JOB_FAILED);
+        co_return;
+    }
+    
+    // Grade now: the reference may have been overwritten while waiting above
+    JobStatus status = JOB_FAILED;         // No echo: nothing looped back
+    if(!job.cancelRequested && captured && copyStoredSignal(job.signalId, -1, reference)) {
+        gradeSelfTest(reference, echo, job.selfTest);
+        status = JOB_DONE;
+        if(job.kind == JOB_CALIBRATE &&
+           !applyCalibration(summary.type, reference, echo, job.selfTest, job.markTrimUs, job.spaceTrimUs)) {
+            status = JOB_FAILED;
+        }
+    }
+    
+    // Captures end on silence, so the frame is normally out already
+    if(co_await frameSent(summary.type) == FLOW_CANCELLED) {
+        abortTransmit(summary.type);
+        completeJob(job, JOB_CANCELLED);
+        co_return;
+    }
+    
+    if(status == JOB_DONE && job.kind == JOB_CALIBRATE) {
+        if(summary.type == SIGNAL_TYPE_IR) LOG_EVENT(EVT_IR_CALIBRATED, summary.number);
+        if(summary.type == SIGNAL_TYPE_RF) LOG_EVENT(EVT_RF_CALIBRATED, summary.number);
+    } else if(status == JOB_DONE) {
+        uint16_t worst = (uint16_t)min(job.selfTest.maxAbsErrorUs, 65535u);
+        if(job.selfTest.passed) LOG_EVENT(EVT_SELFTEST_PASSED, summary.number, worst);
+        else LOG_EVENT(EVT_SELFTEST_FAILED, summary.number, worst);
+    }
+    completeJob(job, status);
+}
+
+Flow jobFlow(Job& job, RawSignal& signal) {
+    if(job.kind == JOB_CAPTURE) return captureFlow(job, signal);
+    if(job.kind == JOB_REPLAY) return replayFlow(job, signal);
+    return selfTestFlow(job, signal);
+}
+
+// One pass of the signal task: resume its flows and start the next job.
+// Returns how long the task may sleep (ms, ULONG_MAX = until notified).
+unsigned long runSignalWork() {
+    static RawSignal signal;
+    
+    unsigned long wait = signalFlows.run();
+    
+    // An IR flow waiting for its frame must not be held up by a capture loop
+    Job* job = signalFlows.full() ? NULL : startNextJob(irFramePending ? RESOURCES_RX : 0);
+    if(!job) return wait;
+    
+    if(!signalFlows.spawn(jobFlow(*job, signal), &job->cancelRequested)) {
+        completeJob(*job, JOB_FAILED);
+    }
+    return 0;
+}
+
+void signalTask(void* param) {
+    for(;;) {
+        unsigned long wait = runSignalWork();
+        if(wait) ulTaskNotifyTake(pdTRUE, wait == ULONG_MAX ? portMAX_DELAY : pdMS_TO_TICKS(wait));
+    }
+}
+
+// ============================================================================
+// JSON RESPONSE WRITER
+// ============================================================================
+
+/*
+ * Streaming JSON writer
+ *
+ * Formats into a fixed buffer and sends it as HTTP chunks whenever the
+ * buffer fills, so a response never allocates no matter how many signals
+ * or log entries it contains. Strings are escaped; separators and nesting
+ * are tracked per level. Pass NULL as key for array elements.
+ */
+class JsonWriter {
+public:
+    explicit JsonWriter(WebServer& server) : server(server) {}
+    
+    // Send headers for a chunked response of unknown length
+    void begin(int code = 200) {
+        server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+        server.send(code, "application/json", "");
+    }
+    
+    // Flush the remaining buffer; the server terminates the chunked body
+    void end() {
+        flush();
+    }
+    
+    void beginObject(const char* key = NULL) { open(key, '{'); }
+    void endObject() { close('}'); }
+    void beginArray(const char* key = NULL) { open(key, '['); }
+    void endArray() { close(']'); }
+    
+    void field(const char* key, const char* value) {
+        separate(key);
+        writeString(value);
+    }
+    
+    void field(const char* key, bool value) {
+        separate(key);
+        write(value ? "true" : "false", value ? 4 : 5);
+    }
+    
+    // Digits are formatted by hand: snprintf() costs more than the rest
+    // of a field, and 64-bit division is slow on the ESP32, so values of
+    // 32 bits or less are divided as such
+    template<typename T, typename std::enable_if<std::is_integral<T>::value, int>::type = 0>
+    void field(const char* key, T value) {
+        typedef typename std::conditional<(sizeof(T) > 4), unsigned long long, uint32_t>::type Magnitude;
+        bool negative = false;
+        Magnitude magnitude = (Magnitude)value;
+        if constexpr (std::is_signed<T>::value) {
+            negative = value < 0;
+            if(negative) magnitude = (Magnitude)0 - magnitude;
+        }
+        
+        char digits[24];
+        char* end = digits + sizeof(digits);
+        char* p = end;
+        do {
+            *--p = (char)('0' + magnitude % 10);
+            magnitude /= 10;
+        } while(magnitude);
+        if(negative) *--p = '-';
+        
+        separate(key);
+        write(p, end - p);
+    }
+    
+private:
+    WebServer& server;
+    char buffer[JSON_BUFFER_SIZE];
+    size_t used = 0;
+    uint32_t levelHasItems = 0; // Bit per nesting level
+    uint8_t depth = 0;
+    
+    void flush() {
+        if(used > 0) {
+            server.sendContent(buffer, used);
+            used = 0;
+        }
+    }
+    
+    void put(char c) {
+        if(used == sizeof(buffer)) flush();
+        buffer[used++] = c;
+    }
+    
+    void write(const char* data, size_t length) {
+        while(length > 0) {
+            if(used == sizeof(buffer)) flush();
+            size_t chunk = min(length, sizeof(buffer) - used);
+            memcpy(buffer + used, data, chunk);
+            used += chunk;
+            data += chunk;
+            length -= chunk;
+        }
+    }
+    
+    // Runs of characters that need no escaping are copied whole
+    void writeString(const char* value) {
+        put('"');
+        for(const char* p = value; *p; p++) {
+            const char* run = p;
+            while((unsigned char)*p >= 0x20 && *p != '"' && *p != '\\') p++;
+            write(run, p - run);
+            if(!*p) break;
+            
+            unsigned char c = *p;
+            switch(c) {
+                case '"':  write("\\\"", 2); break;
+                case '\\': write("\\\\", 2); break;
+                case '\n': write("\\n", 2); break;
+                case '\r': write("\\r", 2); break;
+                case '\t': write("\\t", 2); break;
+                default: {
+                    char escaped[8];
+                    write(escaped, snprintf(escaped, sizeof(escaped), "\\u%04x", c));
+                }
+            }
+        }
+        put('"');
+    }
+    
+    // Emit the comma before an item and its key, if any
+    void separate(const char* key) {
+        uint32_t bit = 1UL << depth;
+        if(levelHasItems & bit) put(',');
+        levelHasItems |= bit;
+        
+        if(key) {
+            writeString(key);
+            put(':');
+        }
+    }
+    
+    void open(const char* key, char bracket) {
+        separate(key);
+        put(bracket);
+        depth++;
+        levelHasItems &= ~(1UL << depth);
+    }
+    
+    void close(char bracket) {
+        depth--;
+        put(bracket);
+    }
+};
+
+// ============================================================================
+// WEB SERVER HANDLERS
+// ============================================================================
+
+/*
+ * Web UI
+ *
+ * The page source lives in web/index.html. tools/build_html.py minifies and
+ * gzips it into the array below; rerun it after editing the page. The
+ * ETag is derived from the compressed bytes, so browsers revalidate with
+ * If-None-Match and get a body-less 304 until the firmware changes.
+ */
+// BEGIN GENERATED HTML_PAGE (tools/build_html.py from web/index.html, do not edit)
+const uint8_t HTML_PAGE_GZ[] PROGMEM = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0xad, 0x5a, 0xdd, 0x6e, 0x1b, 0xc7,
+    0x15, 0xbe, 0xd7, 0x53, 0x4c, 0x98, 0x36, 0x24, 0x6b, 0xf1, 0x47, 0x92, 0x95, 0x58, 0x14, 0x49,
+    0x43, 0xb1, 0x95, 0x5a, 0x81, 0x62, 0x1b, 0x92, 0xd3, 0xa0, 0x35, 0x8c, 0x76, 0xb8, 0x3b, 0x14,
+    0x37, 0x5e, 0xee, 0x6c, 0x77, 0x87, 0xa2, 0x18, 0x45, 0x40, 0x2f, 0x7a, 0xd5, 0x02, 0x2d, 0xd0,
+    0xf4, 0xaa, 0x37, 0x6d, 0x9f, 0xa0, 0xb7, 0xed, 0xeb, 0xe4, 0x05, 0xda, 0x47, 0xe8, 0x77, 0xe6,
+    0x67, 0x77, 0x76, 0x49, 0xd1, 0x6e, 0x50, 0x18, 0xb1, 0x77, 0xe7, 0xe7, 0xfc, 0x9f, 0xef, 0x9c,
+    0xc3, 0xcd, 0xf0, 0x83, 0xa7, 0x2f, 0x9e, 0xbc, 0xfa, 0xf9, 0xcb, 0x53, 0x36, 0x53, 0xf3, 0x78,
+    0x3c, 0xb4, 0x7f, 0x0b, 0x1e, 0x8e, 0x87, 0x2a, 0x52, 0xb1, 0x18, 0x9f, 0x5e, 0xbe, 0x3c, 0xd8,
+    0x67, 0x97, 0x22, 0x58, 0x64, 0x91, 0x5a, 0xb1, 0x0b, 0x91, 0x0b, 0x9e, 0x05, 0x33, 0x76, 0xce,
+    0x27, 0xc3, 0x9e, 0x39, 0x32, 0x9c, 0x0b, 0xc5, 0x59, 0xc2, 0xe7, 0x62, 0xd4, 0xb8, 0x8e, 0xc4,
+    0x32, 0x95, 0x99, 0x6a, 0xb0, 0x40, 0x26, 0x4a, 0x24, 0x6a, 0xd4, 0x58, 0x46, 0xa1, 0x9a, 0x8d,
+    0x42, 0x71, 0x1d, 0x05, 0xa2, 0xa3, 0x5f, 0x76, 0x59, 0x94, 0x44, 0x2a, 0xe2, 0x71, 0x27, 0x0f,
+    0x78, 0x2c, 0x46, 0x7b, 0x8d, 0xf1, 0x30, 0x57, 0x2b, 0x90, 0x9a, 0xc8, 0x70, 0x75, 0x3b, 0xc5,
+    0xcd, 0xce, 0x94, 0xcf, 0xa3, 0x78, 0x35, 0x38, 0xc9, 0x70, 0x6c, 0x37, 0xe7, 0x49, 0xde, 0xc9,
+    0x45, 0x16, 0x4d, 0x8f, 0xe7, 0xfc, 0xc6, 0x10, 0x19, 0xec, 0xed, 0xf7, 0xfb, 0xe9, 0x0d, 0x16,
+    0xb2, 0xab, 0x28, 0x19, 0xf4, 0x19, 0x5f, 0x28, 0x79, 0x9c, 0xf2, 0x30, 0x8c, 0x92, 0xab, 0xc1,
+    0x3e, 0x6d, 0x4d, 0x78, 0xf0, 0xf6, 0x2a, 0x93, 0x8b, 0x24, 0x1c, 0x7c, 0x38, 0x3d, 0xa4, 0x3f,
+    0x77, 0x5d, 0xd2, 0x4d, 0x64, 0xb7, 0xfe, 0xd6, 0x7e, 0x70, 0x20, 0x0e, 0xfb, 0xc7, 0x81, 0x8c,
+    0x65, 0x36, 0x58, 0xce, 0x22, 0x25, 0x6a, 0x64, 0x64, 0x86, 0x2b, 0x9d, 0x8c, 0x87, 0xd1, 0x22,
+    0x1f, 0x3c, 0x2a, 0x78, 0x76, 0x26, 0x52, 0x29, 0x39, 0xd7, 0x87, 0xee, 0xba, 0x4b, 0x9e, 0x25,
+    0xb8, 0x52, 0xa1, 0x2c, 0x3e, 0x79, 0x18, 0x1c, 0x04, 0x1b, 0x29, 0xef, 0x1d, 0xae, 0x51, 0x3e,
+    0xbc, 0x87, 0x72, 0xc0, 0xb3, 0xd0, 0x27, 0xfb, 0x03, 0x45, 0xc4, 0xa1, 0x9b, 0x4e, 0x3e, 0xe3,
+    0xa1, 0x5c, 0xc2, 0x5a, 0xfb, 0xe9, 0x0d, 0x7b, 0x88, 0xff, 0xb2, 0xab, 0x09, 0x6f, 0xf5, 0x77,
+    0xf5, 0x9f, 0xee, 0x5e, 0xfb, 0xae, 0x9b, 0x2b, 0xae, 0x16, 0xf9, 0x6d, 0x18, 0xe5, 0x69, 0xcc,
+    0x57, 0x83, 0x28, 0x89, 0xa3, 0x44, 0x74, 0x26, 0xb1, 0x0c, 0xde, 0x16, 0x3c, 0x21, 0x29, 0xdb,
+    0xa0, 0x80, 0xe6, 0xa2, 0xbd, 0xb7, 0x14, 0xd1, 0xd5, 0x4c, 0x0d, 0x26, 0x32, 0x0e, 0x9d, 0x24,
+    0xb1, 0x98, 0xaa, 0xc1, 0x9e, 0x56, 0xc8, 0xb0, 0xe8, 0x44, 0x61, 0x2c, 0x2a, 0xe6, 0x3a, 0x3a,
+    0xe4, 0x87, 0xfc, 0x63, 0xdf, 0x5c, 0xc5, 0xd9, 0x80, 0xa7, 0x0a, 0x11, 0x58, 0xb3, 0xef, 0xf4,
+    0xe0, 0x28, 0xd8, 0xdb, 0xdf, 0x78, 0x21, 0x13, 0x24, 0xfe, 0xbb, 0x1d, 0x72, 0x37, 0x59, 0xc0,
+    0x42, 0x49, 0xe5, 0xd4, 0xc1, 0xc3, 0xa3, 0x47, 0xe1, 0xa4, 0xe2, 0x36, 0xa3, 0xe8, 0x20, 0x91,
+    0x89, 0xe7, 0x42, 0x28, 0xc3, 0x36, 0x98, 0x9f, 0x0c, 0x83, 0x74, 0xc9, 0x71, 0x39, 0x95, 0x11,
+    0xb2, 0x20, 0x33, 0x46, 0xc9, 0xa3, 0x6f, 0xc4, 0x60, 0xef, 0x61, 0x19, 0xb3, 0x38, 0x68, 0xd9,
+    0x0f, 0x66, 0xf2, 0xba, 0x1e, 0x95, 0x47, 0x8f, 0xfa, 0x93, 0x23, 0xb7, 0x0f, 0x77, 0xf0, 0x49,
+    0x2c, 0x2a, 0x71, 0xf0, 0xe1, 0x24, 0x84, 0x32, 0x9f, 0x38, 0x5e, 0x89, 0x54, 0x1d, 0x1e, 0xc7,
+    0x72, 0x29, 0xc2, 0xbb, 0x6e, 0xc8, 0x93, 0xab, 0x1a, 0x41, 0xa3, 0xbb, 0xdb, 0xda, 0xc0, 0x31,
+    0xe8, 0x1f, 0x1c, 0xed, 0x4f, 0x60, 0xc1, 0x45, 0x10, 0x88, 0x3c, 0xaf, 0x4a, 0xf3, 0x09, 0x17,
+    0x1f, 0xf7, 0x8b, 0xbd, 0x4d, 0xf2, 0xee, 0x1f, 0x1d, 0x1d, 0x3e, 0xbc, 0x53, 0x24, 0xe6, 0xad,
+    0xcd, 0xd0, 0x7e, 0xff, 0xc7, 0xce, 0x36, 0x30, 0x66, 0xcc, 0xd3, 0x5c, 0x0c, 0xdc, 0xc3, 0x1d,
+    0x70, 0x40, 0x85, 0xb7, 0xbe, 0x31, 0x8f, 0x95, 0xb8, 0x21, 0x1d, 0xa2, 0xab, 0x64, 0x40, 0xe1,
+    0xe2, 0xee, 0xda, 0x20, 0xde, 0x83, 0xb9, 0x73, 0x19, 0x47, 0x21, 0xfb, 0x30, 0x0c, 0x43, 0xdc,
+    0xaf, 0x39, 0xed, 0xe1, 0xd1, 0xa1, 0xa8, 0xc6, 0x42, 0x2c, 0xaf, 0x3a, 0xc0, 0xa0, 0x6c, 0x75,
+    0xeb, 0x45, 0xae, 0xb3, 0x3e, 0x65, 0x40, 0xbf, 0x82, 0x11, 0x22, 0x98, 0xf6, 0xa7, 0x7b, 0x8e,
+    0xab, 0x0e, 0xd8, 0x83, 0x92, 0xa7, 0x8d, 0x0a, 0x1f, 0x9d, 0xe6, 0x32, 0x91, 0x79, 0xca, 0x03,
+    0xe1, 0x3b, 0x18, 0x74, 0xef, 0xa2, 0x24, 0x5d, 0xa8, 0xd7, 0x6a, 0x95, 0x02, 0x12, 0x93, 0xc5,
+    0x7c, 0x22, 0xb2, 0xc6, 0x9b, 0x42, 0x86, 0x47, 0x45, 0xc4, 0xd4, 0x54, 0xaa, 0xc5, 0x11, 0x45,
+    0x4a, 0x61, 0x48, 0x10, 0x1d, 0xf6, 0x0c, 0x48, 0x0e, 0x7b, 0x06, 0xa0, 0x09, 0x2c, 0xc7, 0xc3,
+    0x30, 0xba, 0x66, 0x41, 0xcc, 0xf3, 0x7c, 0xd4, 0x30, 0xd8, 0x06, 0x30, 0x9d, 0xed, 0x8d, 0xff,
+    0xf3, 0xd7, 0x3f, 0xff, 0x89, 0x19, 0xf0, 0x7e, 0x06, 0xfc, 0x00, 0x3a, 0x89, 0xfb, 0x50, 0x1c,
+    0xa7, 0x87, 0xe9, 0xf8, 0x34, 0x5c, 0x04, 0x5c, 0x45, 0x32, 0xe1, 0x31, 0x7b, 0x2a, 0xa0, 0x59,
+    0xae, 0x32, 0xfd, 0xce, 0xe4, 0x94, 0x9d, 0x25, 0x39, 0xdd, 0x05, 0x09, 0xf8, 0x46, 0x1f, 0xc8,
+    0xf1, 0xc0, 0x7e, 0xb6, 0x88, 0x13, 0x91, 0xf1, 0x49, 0x14, 0x03, 0xce, 0x45, 0x3e, 0xec, 0xa5,
+    0x5a, 0x9e, 0x31, 0xbb, 0xd4, 0x49, 0x38, 0x60, 0x43, 0x58, 0x27, 0x71, 0xe2, 0x99, 0xcc, 0x64,
+    0x5e, 0xf6, 0x37, 0x58, 0x14, 0x62, 0x7d, 0x95, 0x2b, 0x31, 0x37, 0x57, 0x1a, 0xe3, 0xb3, 0xa7,
+    0xe7, 0xa7, 0xd0, 0x14, 0xf7, 0xc6, 0x8e, 0xdb, 0x13, 0xb8, 0x47, 0x11, 0x31, 0x95, 0xc9, 0xe4,
+    0xca, 0xdc, 0xd1, 0x3b, 0x7a, 0xa3, 0x31, 0xee, 0x93, 0x65, 0x68, 0x6b, 0xcc, 0xce, 0xe5, 0x15,
+    0x7b, 0x9a, 0xc9, 0x34, 0x15, 0x61, 0xf5, 0x02, 0x42, 0xc1, 0xae, 0xfb, 0xe7, 0x87, 0x3d, 0x12,
+    0xd7, 0xfe, 0xed, 0x59, 0xd2, 0x82, 0x79, 0x63, 0xcc, 0xbe, 0xff, 0xcb, 0xdf, 0xfe, 0xfd, 0xcf,
+    0x3f, 0x3a, 0x52, 0xe3, 0xd3, 0xa7, 0x5f, 0x3e, 0x39, 0x79, 0x75, 0xf6, 0xe2, 0xf9, 0xc9, 0x39,
+    0xfb, 0xf2, 0xf2, 0x94, 0xbd, 0x78, 0x7e, 0xfe, 0xf3, 0x92, 0x7b, 0x87, 0xbd, 0x9a, 0x45, 0xd0,
+    0x50, 0x2b, 0xc4, 0xc2, 0xc2, 0x8a, 0x22, 0x67, 0xcb, 0xd9, 0x8a, 0xc5, 0xe2, 0x8a, 0x07, 0x2b,
+    0x76, 0x76, 0xd1, 0xbb, 0xf8, 0xcc, 0x1e, 0xc2, 0x46, 0xa4, 0x66, 0x72, 0xa1, 0xa8, 0x7c, 0xcd,
+    0x10, 0xab, 0x91, 0x71, 0x02, 0x23, 0x7f, 0x5d, 0x5b, 0xf3, 0xc6, 0x82, 0x29, 0xc9, 0x0c, 0xa2,
+    0x31, 0xae, 0x14, 0x42, 0x36, 0xef, 0xb2, 0x2f, 0x24, 0x9c, 0x9d, 0x30, 0xeb, 0x18, 0x47, 0x6e,
+    0x91, 0x0b, 0x96, 0x21, 0xc5, 0x20, 0x3d, 0x4a, 0x70, 0x08, 0xce, 0x3c, 0x09, 0x99, 0x48, 0x82,
+    0x6c, 0x95, 0x6a, 0xc2, 0xa0, 0x94, 0x66, 0xe2, 0x1a, 0xac, 0x18, 0x18, 0xe2, 0x74, 0x41, 0xf0,
+    0x4b, 0xbc, 0xc8, 0x24, 0x5e, 0xe1, 0x2f, 0x66, 0xca, 0x75, 0xce, 0x56, 0x72, 0xc1, 0xe4, 0x32,
+    0x41, 0xc1, 0x66, 0x5c, 0x97, 0x74, 0xa2, 0x2d, 0x42, 0x16, 0xf3, 0x09, 0x88, 0x5e, 0x47, 0xd0,
+    0x7b, 0x0e, 0x52, 0x5d, 0xb6, 0x6e, 0x43, 0x2a, 0x5b, 0x14, 0x8b, 0xfb, 0x88, 0xc5, 0xef, 0xfe,
+    0x5e, 0xf8, 0x52, 0x03, 0xb9, 0x40, 0xd4, 0xed, 0x53, 0xd4, 0xd9, 0x57, 0xd8, 0x84, 0xc9, 0x8c,
+    0x91, 0x59, 0xf4, 0xb1, 0x9c, 0x4d, 0x33, 0x39, 0x07, 0x57, 0xab, 0x9d, 0x15, 0xa7, 0x6b, 0xec,
+    0xbb, 0x66, 0xd8, 0x9a, 0xed, 0x70, 0x24, 0x40, 0x9c, 0xe3, 0x35, 0xee, 0xea, 0x98, 0x34, 0x20,
+    0x0a, 0xbd, 0x82, 0x38, 0x0a, 0xde, 0x92, 0x68, 0x9a, 0xab, 0x11, 0xa9, 0xd5, 0x3c, 0xbb, 0x68,
+    0xb6, 0x4d, 0x28, 0x4e, 0x54, 0x62, 0x25, 0x3a, 0xbb, 0x68, 0xf8, 0xc2, 0x99, 0xa3, 0xc3, 0x9e,
+    0xa1, 0xf4, 0x4e, 0x8a, 0x17, 0x9f, 0xad, 0x53, 0xbc, 0xf8, 0xac, 0xa4, 0x08, 0x45, 0xdf, 0x4d,
+    0x31, 0x09, 0x44, 0xfc, 0xb9, 0x9c, 0xe4, 0x2d, 0x90, 0xb2, 0x36, 0x35, 0xd8, 0xed, 0x51, 0x76,
+    0x67, 0x1a, 0xcc, 0x55, 0x88, 0xb1, 0x59, 0x2c, 0x09, 0x6f, 0x77, 0xcc, 0xef, 0x9d, 0x47, 0x42,
+    0x2b, 0x51, 0x6e, 0x5c, 0xa3, 0x2f, 0xe5, 0x22, 0x16, 0x81, 0xd2, 0xdc, 0x52, 0x7e, 0x25, 0x5e,
+    0x01, 0xcf, 0x1a, 0x24, 0xe1, 0x8c, 0xc4, 0x40, 0x12, 0xce, 0xe4, 0xf2, 0x25, 0xd6, 0x5b, 0xfd,
+    0x36, 0xe8, 0x49, 0x13, 0x5f, 0xd7, 0x3c, 0x5e, 0x60, 0xaf, 0x31, 0x3e, 0x89, 0x63, 0x46, 0x08,
+    0x08, 0x82, 0x66, 0xab, 0x7e, 0x84, 0x4c, 0x7c, 0x76, 0x71, 0xdf, 0x2e, 0x99, 0xeb, 0xe2, 0xb3,
+    0x72, 0xb7, 0x67, 0x84, 0x59, 0x13, 0xea, 0x52, 0x77, 0x9b, 0xef, 0x27, 0x14, 0xd2, 0x21, 0x68,
+    0x8c, 0x9f, 0x8b, 0xa5, 0xc8, 0x15, 0x9b, 0x46, 0x59, 0xae, 0xee, 0xe3, 0xce, 0xe9, 0xe0, 0x8b,
+    0x38, 0xdc, 0x70, 0xb0, 0x10, 0xc4, 0x18, 0x56, 0x17, 0x3c, 0x0f, 0x93, 0x5e, 0xd1, 0x3b, 0x38,
+    0x2b, 0xdb, 0x45, 0x67, 0xf4, 0x08, 0x54, 0x43, 0xb7, 0x3c, 0xd3, 0x8f, 0x64, 0xc5, 0xe2, 0xe5,
+    0x5c, 0x24, 0x57, 0x6a, 0x56, 0xbc, 0xbe, 0x44, 0x66, 0xa2, 0x83, 0x2e, 0xcf, 0x46, 0x73, 0x48,
+    0xc0, 0xe7, 0x69, 0xb1, 0x72, 0x12, 0x90, 0x14, 0xe6, 0xb5, 0x47, 0xc4, 0x7b, 0x8e, 0x11, 0x95,
+    0x83, 0xba, 0x1c, 0x9f, 0x62, 0xad, 0x61, 0x85, 0x08, 0x91, 0xbf, 0x31, 0xe1, 0xea, 0xa8, 0xf1,
+    0x71, 0x83, 0xe9, 0x52, 0x32, 0x6a, 0x78, 0x15, 0x37, 0x10, 0xba, 0x55, 0x81, 0x7d, 0x64, 0x91,
+    0x85, 0x36, 0xac, 0x43, 0x70, 0x09, 0x0b, 0x7e, 0xa6, 0xee, 0xf4, 0xb4, 0xe2, 0x36, 0x50, 0xea,
+    0xc1, 0x5b, 0x38, 0x81, 0x3c, 0xf4, 0x62, 0x3a, 0xcd, 0x85, 0x02, 0x38, 0xbe, 0x3c, 0xf9, 0xe9,
+    0xe9, 0x2f, 0x2f, 0xcf, 0x7e, 0x71, 0x5a, 0xe6, 0x06, 0x29, 0x4c, 0x07, 0xbd, 0xf8, 0xa5, 0xa5,
+    0x32, 0x7a, 0x75, 0x01, 0x71, 0xbe, 0x3e, 0x4b, 0xa6, 0x12, 0xf0, 0x4d, 0x15, 0xa9, 0x6f, 0x6b,
+    0xc4, 0x7b, 0xb1, 0x7e, 0xb0, 0x89, 0xf5, 0x73, 0xa8, 0x5e, 0x63, 0x4d, 0x4b, 0xf5, 0xc4, 0xd9,
+    0x9a, 0x3e, 0x7f, 0xf8, 0x07, 0x3b, 0xd1, 0xf0, 0x89, 0xe4, 0x99, 0x2f, 0x62, 0x03, 0x3f, 0x04,
+    0xcc, 0x0e, 0xdf, 0x9e, 0xfa, 0x50, 0x95, 0x8b, 0x5f, 0x2f, 0x08, 0xa6, 0x00, 0x83, 0x55, 0x30,
+    0x27, 0xc4, 0x2d, 0xb0, 0xce, 0x22, 0x79, 0x17, 0x45, 0x37, 0x88, 0x17, 0x84, 0xe0, 0x53, 0x1e,
+    0xc5, 0x39, 0x9f, 0xa2, 0x0a, 0x20, 0x1c, 0xa8, 0x56, 0xa4, 0x99, 0x54, 0x42, 0x07, 0x42, 0xb7,
+    0xa8, 0xb9, 0x43, 0x40, 0xb2, 0x88, 0xc1, 0x90, 0xe8, 0x4e, 0x84, 0x5a, 0x0a, 0x91, 0x58, 0x36,
+    0x39, 0x6b, 0xcd, 0xf3, 0x36, 0xea, 0x61, 0xcf, 0x9c, 0x19, 0xea, 0xf6, 0x84, 0x55, 0xda, 0x13,
+    0x6d, 0x15, 0x23, 0x8e, 0x26, 0xd1, 0x70, 0x99, 0x80, 0xde, 0xa3, 0xdf, 0x60, 0xf3, 0x08, 0x61,
+    0x73, 0xa8, 0x9f, 0xf8, 0x8d, 0x59, 0xec, 0x53, 0x10, 0x89, 0x54, 0xbf, 0x34, 0x7c, 0x3b, 0xd9,
+    0xd0, 0xb2, 0x7d, 0xbf, 0x92, 0xe9, 0x80, 0xe9, 0xee, 0xae, 0xb1, 0xc1, 0x59, 0x8a, 0x67, 0xca,
+    0x58, 0x10, 0x06, 0xbc, 0x1f, 0xe8, 0x2e, 0xcb, 0x73, 0x8d, 0xb1, 0x7e, 0x41, 0x33, 0x53, 0x18,
+    0xf3, 0x42, 0x6b, 0x79, 0x3f, 0x94, 0xe6, 0x90, 0x61, 0x13, 0x13, 0xdb, 0xcc, 0x7a, 0x5c, 0xdc,
+    0x39, 0x62, 0x22, 0x53, 0xcf, 0xa9, 0xff, 0x53, 0x54, 0x7c, 0xf7, 0x3b, 0x46, 0x69, 0x7a, 0x4d,
+    0xad, 0x16, 0x1a, 0x92, 0x02, 0x50, 0x8d, 0x8d, 0xed, 0x0e, 0x36, 0x1a, 0xa5, 0xa9, 0x6e, 0x3a,
+    0x33, 0x33, 0x32, 0xb1, 0x03, 0x3d, 0xd5, 0x32, 0xea, 0xaf, 0xa7, 0x68, 0xe6, 0x3b, 0xab, 0x81,
+    0x99, 0x6c, 0x1b, 0x15, 0x76, 0x45, 0x67, 0x0b, 0x49, 0x4d, 0xb7, 0x61, 0x47, 0x6a, 0xb4, 0xa0,
+    0x61, 0x45, 0xc6, 0x2d, 0x92, 0x7e, 0xff, 0xdb, 0x7f, 0x51, 0x6f, 0x53, 0xb4, 0x85, 0x4f, 0x60,
+    0x31, 0x91, 0x2a, 0x5b, 0x01, 0x66, 0x07, 0xe3, 0xaf, 0x66, 0x2b, 0x6b, 0x5c, 0x1b, 0xe6, 0x39,
+    0xfb, 0x4a, 0x66, 0x6f, 0x29, 0x5c, 0xcb, 0x8e, 0xd0, 0x84, 0xeb, 0x00, 0x97, 0x0e, 0xc6, 0xc3,
+    0x05, 0xa2, 0x2b, 0x8e, 0xc6, 0xae, 0x5d, 0x02, 0x94, 0x9c, 0x54, 0x6a, 0xf3, 0xa0, 0x6c, 0x96,
+    0x9e, 0xea, 0x9a, 0xce, 0x78, 0xa0, 0x79, 0xa2, 0x4d, 0x59, 0x51, 0xc8, 0xa1, 0x15, 0x46, 0x94,
+    0x53, 0xf7, 0x92, 0x22, 0x1a, 0xd1, 0xe0, 0x20, 0x68, 0xa3, 0x0a, 0x4d, 0x6a, 0x14, 0xa3, 0x00,
+    0xc2, 0x22, 0x35, 0x3c, 0x72, 0x97, 0x7c, 0x2e, 0x2c, 0x6e, 0x31, 0xe4, 0x5b, 0x92, 0xcf, 0x23,
+    0xdc, 0x47, 0xeb, 0x03, 0x43, 0xae, 0x74, 0xe6, 0xac, 0x51, 0x82, 0x74, 0xa7, 0x45, 0x63, 0xe4,
+    0x93, 0xb2, 0xe8, 0xe7, 0x93, 0x41, 0x03, 0x04, 0x3b, 0xe0, 0xef, 0xa9, 0xcc, 0xe6, 0x86, 0x52,
+    0x8f, 0x94, 0x85, 0xd2, 0xcf, 0xe4, 0xd2, 0xd8, 0xb0, 0x30, 0x06, 0x7b, 0x69, 0x3b, 0x2c, 0x6a,
+    0x57, 0x36, 0x5b, 0xe6, 0xc2, 0xf6, 0x68, 0x75, 0x35, 0xe8, 0x9d, 0x99, 0x5a, 0x66, 0x7a, 0x43,
+    0x26, 0x38, 0x1a, 0x75, 0x2b, 0x4a, 0x9e, 0xeb, 0x58, 0xac, 0xe9, 0xf1, 0x64, 0x86, 0xb9, 0x0f,
+    0x85, 0x44, 0x74, 0xd0, 0xd8, 0xa7, 0xc0, 0x1b, 0xe1, 0x11, 0xbc, 0x40, 0x9e, 0x44, 0x99, 0xa0,
+    0x96, 0x08, 0x8a, 0xca, 0xab, 0x8c, 0xa7, 0x33, 0x98, 0x0f, 0x1c, 0xc2, 0x7c, 0xc6, 0xdf, 0xae,
+    0x5b, 0x65, 0xa3, 0x49, 0x4e, 0x4e, 0x2f, 0xa9, 0x41, 0xcb, 0xe1, 0x9a, 0x98, 0x67, 0x0e, 0x80,
+    0x40, 0x54, 0xce, 0xe7, 0xd4, 0x60, 0x86, 0x5c, 0xf1, 0x35, 0x4a, 0x45, 0xf5, 0xf2, 0x15, 0xb4,
+    0xa6, 0xc9, 0x1d, 0x04, 0x02, 0xcb, 0x65, 0x1c, 0xba, 0x8a, 0xe3, 0x59, 0xd6, 0x04, 0x6e, 0x8e,
+    0x4e, 0x2e, 0x55, 0xe3, 0x9d, 0x18, 0x30, 0x6e, 0x26, 0x87, 0x0b, 0xc4, 0x0d, 0x99, 0x81, 0x8d,
+    0x58, 0xb2, 0x88, 0xe3, 0xe3, 0x9d, 0xe9, 0x22, 0x09, 0x4c, 0xcf, 0x9c, 0xa6, 0xf1, 0xca, 0xcc,
+    0x11, 0x2d, 0x12, 0xa8, 0xcd, 0x6e, 0x77, 0xd6, 0xee, 0xd0, 0x46, 0x37, 0xb3, 0xef, 0xc7, 0x3b,
+    0xa1, 0x0c, 0x16, 0xba, 0x83, 0xbd, 0x12, 0xea, 0x34, 0x16, 0xf4, 0xf8, 0xe9, 0xea, 0x2c, 0x6c,
+    0x35, 0xfd, 0xa9, 0xa4, 0xd9, 0xee, 0x52, 0xa1, 0x7c, 0x62, 0x7e, 0xd2, 0x72, 0x44, 0x88, 0xb4,
+    0x78, 0x7f, 0x0a, 0x3a, 0xfd, 0x9e, 0x53, 0x94, 0x8e, 0x58, 0xb3, 0x3a, 0x0b, 0x35, 0x51, 0xa1,
+    0x4a, 0x92, 0x5d, 0x25, 0xcf, 0x31, 0xc5, 0x67, 0x4f, 0x78, 0x2e, 0x5a, 0xed, 0x6d, 0x0c, 0xca,
+    0x21, 0xe8, 0x1e, 0x09, 0xcb, 0x03, 0x5b, 0xc8, 0x94, 0xa3, 0xd1, 0x66, 0x2a, 0xe5, 0xfe, 0xf1,
+    0x4e, 0x34, 0x6d, 0x79, 0x94, 0x4b, 0xbb, 0x7e, 0x30, 0x1a, 0x31, 0x2a, 0xb8, 0x6e, 0xa1, 0xcd,
+    0x36, 0xd4, 0x61, 0xe8, 0x72, 0xb7, 0x13, 0x50, 0x3d, 0x2c, 0xeb, 0x31, 0x98, 0xec, 0xf5, 0x8f,
+    0xb5, 0x7b, 0xbd, 0x82, 0x3d, 0x62, 0xde, 0xda, 0xfd, 0x0e, 0x2f, 0x78, 0x48, 0x43, 0x1f, 0xfe,
+    0x36, 0xe4, 0xa9, 0xb4, 0x91, 0xf8, 0xf7, 0xa9, 0xec, 0xba, 0x59, 0x28, 0xac, 0xcb, 0xdc, 0xb1,
+    0xbd, 0x97, 0xa3, 0x99, 0x7c, 0xd7, 0x3d, 0x6a, 0x38, 0xcb, 0x7b, 0x24, 0xe4, 0x22, 0x8b, 0xc9,
+    0xa7, 0x3d, 0x9e, 0x46, 0x3d, 0x6b, 0x98, 0xc7, 0x31, 0x32, 0x45, 0x8d, 0x9a, 0x7e, 0xeb, 0x81,
+    0xe7, 0xe6, 0x47, 0x46, 0x52, 0xbd, 0xf1, 0x05, 0x57, 0xb3, 0x2e, 0xa0, 0xdf, 0x4a, 0xbf, 0xcb,
+    0xfa, 0x6d, 0x7d, 0x84, 0x84, 0xd0, 0x07, 0xe8, 0x41, 0x9b, 0x9c, 0xd4, 0x69, 0x6b, 0x36, 0x0f,
+    0xc0, 0xe7, 0x23, 0x5d, 0xb8, 0xe9, 0x00, 0x3d, 0xc0, 0x1c, 0x42, 0x05, 0xb3, 0x16, 0x76, 0xdb,
+    0x3b, 0x5d, 0xc2, 0xda, 0x56, 0xc6, 0x46, 0x63, 0x96, 0x75, 0xbf, 0xce, 0x65, 0xd2, 0x6a, 0xbb,
+    0x45, 0x72, 0x1b, 0xad, 0xdf, 0xd6, 0x7d, 0xd8, 0x8d, 0x75, 0x0f, 0xca, 0x46, 0x70, 0x61, 0x9f,
+    0x7d, 0xf4, 0x91, 0x71, 0xba, 0x91, 0x89, 0x8d, 0x49, 0xa8, 0x4c, 0xa0, 0x09, 0xf4, 0xac, 0xed,
+    0x1f, 0xf0, 0xbb, 0xba, 0xe3, 0x9d, 0x8a, 0x0b, 0xbd, 0x63, 0x66, 0xe7, 0xfe, 0x2c, 0x5c, 0xa4,
+    0x58, 0xb0, 0xd3, 0x93, 0x6e, 0x5c, 0x2b, 0x12, 0xb6, 0x9d, 0x7b, 0x90, 0x41, 0x35, 0xc2, 0x45,
+    0xe2, 0x54, 0x74, 0xd9, 0x12, 0xec, 0xae, 0x8d, 0xac, 0x87, 0xfa, 0x4e, 0x4b, 0x13, 0x7f, 0xcc,
+    0x5a, 0x55, 0xea, 0x7b, 0xda, 0x27, 0xdf, 0xff, 0xe6, 0x3b, 0xb2, 0xb7, 0x3e, 0x32, 0x60, 0xcd,
+    0x7e, 0x53, 0xaf, 0x12, 0x76, 0x15, 0xa9, 0xab, 0xa4, 0xe2, 0xf1, 0x16, 0xc6, 0x5e, 0xb3, 0x0b,
+    0xde, 0xae, 0xe5, 0xac, 0x69, 0xa3, 0x7d, 0xb0, 0x9d, 0x88, 0x6b, 0x5b, 0xab, 0x44, 0xb4, 0x64,
+    0xe3, 0x51, 0x45, 0x94, 0x3b, 0x9d, 0x6f, 0x45, 0xb2, 0x58, 0x1b, 0x1b, 0x78, 0x2c, 0x53, 0xc5,
+    0x04, 0x6f, 0x1d, 0x26, 0x47, 0x26, 0xd7, 0x60, 0x0f, 0x1b, 0xd6, 0x06, 0xc5, 0x48, 0x79, 0xef,
+    0xfd, 0x71, 0x1e, 0xa1, 0x63, 0x30, 0xb1, 0x5a, 0x21, 0x70, 0x7f, 0x50, 0x5a, 0xe0, 0x23, 0x06,
+    0x07, 0xfd, 0x87, 0xa0, 0xaf, 0xd9, 0x0c, 0xb6, 0x87, 0xeb, 0x07, 0x06, 0xcd, 0x4d, 0x1c, 0x1e,
+    0xef, 0xac, 0xe1, 0x7c, 0x89, 0x4b, 0xc0, 0xaa, 0x67, 0x18, 0x87, 0x10, 0x96, 0x7b, 0x1a, 0x93,
+    0xf0, 0x7e, 0x0e, 0xd3, 0xb4, 0xad, 0xf6, 0x27, 0x65, 0xf3, 0x45, 0xc8, 0xba, 0xd9, 0x42, 0x5e,
+    0x14, 0xba, 0x00, 0x2c, 0x81, 0x45, 0x4f, 0x59, 0x5b, 0x10, 0xa2, 0x36, 0x7c, 0x35, 0x8d, 0x6c,
+    0x9b, 0x52, 0x8d, 0x88, 0x6a, 0x72, 0xdd, 0x28, 0x49, 0x44, 0xf6, 0xec, 0xd5, 0x17, 0xe7, 0x84,
+    0x22, 0xff, 0xcf, 0x61, 0xad, 0x79, 0xbc, 0xe3, 0x6c, 0x76, 0xb7, 0x81, 0x97, 0x93, 0x6a, 0xce,
+    0xd3, 0x16, 0x5c, 0x32, 0xde, 0xf9, 0x15, 0x31, 0xdf, 0x01, 0xf7, 0xf1, 0x8f, 0x6e, 0xf3, 0x6e,
+    0x14, 0xde, 0x69, 0x52, 0xc5, 0x02, 0xc1, 0xcd, 0x1d, 0x3d, 0xa0, 0x85, 0xcc, 0x22, 0x90, 0xf9,
+    0x86, 0xe2, 0x43, 0xa7, 0x80, 0xbf, 0xd6, 0x63, 0x34, 0x1e, 0xe8, 0x04, 0x79, 0xfb, 0xec, 0x1b,
+    0x1d, 0x33, 0xcd, 0x1a, 0x25, 0x63, 0x07, 0x6f, 0x71, 0x18, 0xf0, 0xe4, 0x9a, 0xe7, 0xae, 0x47,
+    0x4d, 0xcd, 0x1c, 0xdc, 0xd0, 0xf1, 0xdc, 0xa1, 0xb6, 0xd9, 0x0a, 0xd4, 0x60, 0xe6, 0x73, 0x52,
+    0x63, 0xff, 0x10, 0x76, 0x31, 0x3d, 0x33, 0x5e, 0xf4, 0x00, 0x62, 0x48, 0x8c, 0x6b, 0x32, 0xbb,
+    0x1e, 0xc4, 0x67, 0x56, 0x1f, 0x10, 0x4c, 0x2b, 0xe2, 0x7e, 0xbc, 0xb1, 0xac, 0x9a, 0xed, 0xc6,
+    0xb8, 0x3e, 0x59, 0x18, 0x12, 0x64, 0xda, 0x5f, 0xed, 0xb4, 0xbb, 0x5f, 0xcb, 0x28, 0x69, 0x35,
+    0xc9, 0xc5, 0xc6, 0xb6, 0x18, 0x48, 0xb2, 0xd5, 0xa5, 0xfe, 0x75, 0x40, 0x66, 0x27, 0x31, 0x48,
+    0x19, 0x91, 0xba, 0x56, 0x1d, 0xa4, 0x2c, 0xba, 0xc7, 0x53, 0xf4, 0x73, 0xad, 0x30, 0xe3, 0x4b,
+    0x3b, 0xec, 0x7b, 0x55, 0x51, 0x24, 0xd7, 0x22, 0x96, 0x29, 0x9a, 0x35, 0xa4, 0x9f, 0x58, 0xa2,
+    0x42, 0xa4, 0x14, 0xa6, 0x45, 0x80, 0x7a, 0xb7, 0x5a, 0x86, 0x74, 0x19, 0x99, 0x11, 0xc1, 0x80,
+    0xe5, 0x47, 0x56, 0x03, 0x9c, 0x40, 0x8b, 0xe3, 0x1a, 0x65, 0x9c, 0x29, 0x98, 0x50, 0xec, 0xb6,
+    0xa2, 0xb0, 0xcd, 0xbe, 0xfd, 0x96, 0x99, 0x74, 0xf5, 0x4b, 0x58, 0x8f, 0xdc, 0x0a, 0xa2, 0x70,
+    0x63, 0xcf, 0x5d, 0x69, 0xd6, 0x92, 0x59, 0xbe, 0x45, 0x00, 0x64, 0x5d, 0x78, 0x9e, 0xaf, 0x3e,
+    0x5d, 0x4c, 0xa7, 0x22, 0x03, 0xb0, 0x0c, 0x74, 0x4a, 0xbb, 0x93, 0x13, 0xbd, 0x4c, 0xc7, 0xed,
+    0x13, 0x0a, 0x0c, 0xa9, 0xf6, 0x65, 0x94, 0xa8, 0x47, 0x27, 0x74, 0xd1, 0x1e, 0x69, 0x43, 0xd1,
+    0x52, 0xb4, 0x5c, 0x8b, 0xb6, 0x5b, 0x08, 0xeb, 0x6d, 0x1a, 0xba, 0x31, 0xba, 0xc8, 0x38, 0x2f,
+    0x11, 0xc2, 0xbc, 0x17, 0xb5, 0xaa, 0xa4, 0x14, 0xc2, 0x1f, 0x4a, 0x90, 0x9e, 0xce, 0x16, 0x81,
+    0xba, 0x29, 0x4d, 0x05, 0x1b, 0xe8, 0x1a, 0x70, 0xa3, 0x5a, 0xcd, 0xfd, 0xb0, 0x59, 0x1c, 0x9a,
+    0x95, 0x47, 0x4c, 0x94, 0x01, 0x52, 0xf6, 0xb1, 0xa9, 0x6e, 0xba, 0xd3, 0x28, 0x8e, 0x2f, 0x29,
+    0x23, 0x29, 0x5d, 0xed, 0x67, 0x01, 0x64, 0x1a, 0x5c, 0xdb, 0xa2, 0x6e, 0x60, 0xa2, 0xbb, 0x17,
+    0xfc, 0x33, 0x64, 0x46, 0x28, 0x97, 0xf5, 0x3d, 0x10, 0x60, 0x93, 0x07, 0x0f, 0x3c, 0x34, 0xc1,
+    0x8c, 0x39, 0xb2, 0xa7, 0x5e, 0xef, 0xb3, 0x9f, 0xe0, 0x12, 0x2a, 0xce, 0x1b, 0x18, 0x75, 0x0f,
+    0x66, 0x9c, 0x39, 0x59, 0xcc, 0xf7, 0x8f, 0xda, 0x49, 0xff, 0x94, 0x15, 0xea, 0x02, 0x81, 0xd7,
+    0x9a, 0xec, 0x12, 0xd9, 0x5d, 0xb6, 0xb7, 0xeb, 0xee, 0x75, 0x34, 0x1f, 0x2a, 0x65, 0x14, 0x69,
+    0x06, 0xf3, 0x48, 0x50, 0x8b, 0x8d, 0x1b, 0xfa, 0xe8, 0x30, 0x04, 0x40, 0x9e, 0x62, 0xbc, 0x8c,
+    0x44, 0xde, 0x12, 0xe6, 0xdf, 0x52, 0x6a, 0xea, 0x07, 0x31, 0x4e, 0x6e, 0x01, 0x41, 0x6f, 0xc6,
+    0x2d, 0x2d, 0x3a, 0xc5, 0x10, 0x42, 0x56, 0x2d, 0xd8, 0x96, 0x35, 0xc6, 0xb2, 0x80, 0x36, 0xf6,
+    0x89, 0xd4, 0x01, 0xbe, 0xb5, 0x04, 0x39, 0x58, 0x20, 0x1a, 0x7e, 0x8d, 0x4e, 0xc4, 0x61, 0xb9,
+    0x46, 0x54, 0x4d, 0xad, 0x86, 0xa7, 0x0e, 0xeb, 0x4a, 0xc5, 0xf4, 0xa9, 0xd7, 0x95, 0xb3, 0xa8,
+    0x0c, 0x6f, 0x88, 0xa0, 0x3e, 0x06, 0x3d, 0xba, 0xf4, 0xc3, 0x4b, 0xa6, 0x4e, 0xc2, 0xaf, 0x39,
+    0x81, 0x2a, 0x41, 0x23, 0x14, 0x98, 0x82, 0xfb, 0x44, 0x5c, 0x45, 0x49, 0x73, 0xd7, 0x10, 0xd1,
+    0x20, 0xa9, 0x27, 0x6e, 0x03, 0x94, 0x9b, 0x67, 0xf1, 0xd7, 0x3f, 0xba, 0xd5, 0x4f, 0x1e, 0xec,
+    0xbc, 0x61, 0x6e, 0x0d, 0x2b, 0x39, 0x0a, 0xf7, 0x9d, 0x99, 0x6c, 0x08, 0x40, 0x68, 0x14, 0xca,
+    0xa8, 0xc9, 0x2f, 0xa0, 0x04, 0xca, 0x2d, 0x67, 0x11, 0x2a, 0x8f, 0x15, 0x2e, 0xc0, 0x4b, 0x98,
+    0x89, 0xc4, 0x49, 0x3f, 0x66, 0xfb, 0x7d, 0x68, 0x6a, 0x77, 0xa9, 0xea, 0x3f, 0xa1, 0x13, 0xa0,
+    0x34, 0x97, 0xd7, 0x7a, 0x5a, 0x58, 0xab, 0x67, 0x95, 0x9a, 0x57, 0x2b, 0xfb, 0x1b, 0x7c, 0x61,
+    0x30, 0x00, 0x1b, 0x65, 0xb1, 0xc7, 0x8b, 0x57, 0xe9, 0xed, 0x9d, 0x1f, 0xd4, 0x77, 0xd6, 0xf9,
+    0xb5, 0xdf, 0x33, 0x86, 0xaa, 0x25, 0x12, 0xc9, 0x56, 0x0d, 0x51, 0x5d, 0xfa, 0x5d, 0x9c, 0x7a,
+    0xcd, 0x80, 0x63, 0xb5, 0x48, 0x42, 0x31, 0x8d, 0x12, 0x11, 0x96, 0x31, 0xb2, 0x41, 0x18, 0xc2,
+    0xc1, 0xf2, 0x5e, 0x19, 0x6f, 0x5e, 0xa2, 0x14, 0xdb, 0xc7, 0x5e, 0x1e, 0xd9, 0x79, 0x76, 0x2d,
+    0x8d, 0x60, 0xe8, 0x04, 0x19, 0x79, 0xaa, 0xb7, 0xb5, 0xe9, 0x09, 0xa8, 0x96, 0x51, 0x12, 0xca,
+    0x65, 0x57, 0xaf, 0x5e, 0xca, 0x45, 0x16, 0x88, 0x52, 0xa8, 0x92, 0x12, 0x10, 0xd2, 0x3b, 0x61,
+    0x81, 0xd9, 0x6c, 0x53, 0x46, 0x99, 0xa7, 0x2e, 0xac, 0xa0, 0x4f, 0x9d, 0x47, 0x98, 0x34, 0x61,
+    0xa0, 0x56, 0x13, 0x90, 0x47, 0x21, 0x0b, 0x6e, 0x30, 0x79, 0xb5, 0xe3, 0xdb, 0x76, 0xcd, 0xb6,
+    0x77, 0xc0, 0x5b, 0xba, 0xe7, 0xf7, 0x57, 0x9f, 0x5f, 0xbe, 0x78, 0xde, 0x4d, 0x39, 0x45, 0xa9,
+    0xd0, 0x75, 0xa5, 0xbd, 0x95, 0x10, 0xc5, 0x8d, 0xa3, 0x52, 0x71, 0xd1, 0xeb, 0x75, 0x42, 0x6f,
+    0xb6, 0x52, 0xfa, 0x5a, 0x4e, 0x1c, 0x25, 0x17, 0xb3, 0x58, 0x82, 0x6d, 0xd6, 0x09, 0x69, 0x6f,
+    0x62, 0xd3, 0x35, 0x97, 0xd4, 0xf8, 0x35, 0x51, 0x8c, 0x17, 0x98, 0x68, 0xa9, 0xde, 0xd4, 0xb7,
+    0xb2, 0x45, 0x42, 0x5f, 0xf7, 0xd0, 0xc4, 0x23, 0x28, 0xa2, 0x7c, 0xf6, 0xb9, 0x9c, 0xd0, 0x75,
+    0xdb, 0x10, 0xde, 0x2b, 0x11, 0x60, 0x60, 0x95, 0x04, 0x85, 0x75, 0x37, 0xfc, 0xb6, 0x60, 0x02,
+    0xa0, 0x6a, 0x76, 0xf7, 0xbe, 0xb1, 0xf5, 0x34, 0x7a, 0xc1, 0x67, 0xf4, 0x61, 0x98, 0xbe, 0xe3,
+    0xdc, 0x53, 0xf8, 0xf3, 0xc5, 0x04, 0xe3, 0x24, 0xc9, 0x89, 0x74, 0xdb, 0x45, 0xd2, 0x24, 0x82,
+    0xe2, 0xa9, 0xc8, 0xc0, 0x5d, 0x76, 0x3b, 0x17, 0x6a, 0x26, 0x43, 0xa4, 0xec, 0xcb, 0x17, 0x97,
+    0xaf, 0x9a, 0x77, 0xef, 0x9f, 0x93, 0xba, 0xb9, 0xee, 0x92, 0xfe, 0x78, 0xe7, 0x31, 0xb0, 0xd0,
+    0x64, 0x8f, 0x85, 0xab, 0xb6, 0xdf, 0x43, 0x7a, 0x92, 0xea, 0x12, 0xed, 0xae, 0x5a, 0x91, 0xb6,
+    0x4f, 0x2e, 0xe5, 0xd7, 0xaa, 0xea, 0xec, 0x32, 0x45, 0x0f, 0x8a, 0x31, 0x36, 0x95, 0x31, 0x6d,
+    0x16, 0x34, 0xdb, 0xeb, 0x96, 0xac, 0xf5, 0xeb, 0xd5, 0x8f, 0x6e, 0x66, 0x48, 0x86, 0x57, 0x0a,
+    0x5b, 0x99, 0xac, 0xb1, 0xa7, 0x1e, 0x57, 0xa6, 0xe6, 0x5d, 0xd6, 0xb4, 0x1f, 0x24, 0x5d, 0xd7,
+    0x0c, 0xcb, 0x55, 0xa9, 0x57, 0x63, 0xa3, 0x08, 0x42, 0x52, 0x14, 0x42, 0xfb, 0x96, 0xa0, 0x3e,
+    0x8a, 0x62, 0x4c, 0xf7, 0x18, 0x04, 0x3e, 0xfa, 0xc8, 0x66, 0xdc, 0xf1, 0xef, 0xd9, 0xd6, 0xa4,
+    0xb8, 0xfa, 0x43, 0x8c, 0x57, 0xf1, 0x48, 0xf4, 0x8d, 0x70, 0x23, 0xa4, 0x71, 0xa4, 0x17, 0xf9,
+    0xb4, 0xde, 0x24, 0xc9, 0x9a, 0x00, 0x79, 0x2d, 0xe1, 0x03, 0x93, 0x18, 0xc6, 0x0c, 0x03, 0xfd,
+    0xf2, 0x16, 0xe0, 0xa4, 0x1b, 0xf7, 0xa6, 0xdb, 0xd5, 0x97, 0x37, 0xb9, 0xa2, 0x34, 0x94, 0x73,
+    0x1c, 0xb5, 0x92, 0xce, 0x4a, 0xe9, 0x22, 0x9f, 0x69, 0xf9, 0x2c, 0xa4, 0x21, 0x0b, 0x6d, 0x5e,
+    0x65, 0x18, 0xcf, 0x34, 0xb8, 0x18, 0x51, 0x3d, 0x94, 0xeb, 0xbe, 0x78, 0x79, 0xfa, 0xfc, 0x78,
+    0x07, 0x71, 0xf5, 0xca, 0x7c, 0xe7, 0x68, 0xb9, 0x44, 0xa3, 0x28, 0xf5, 0x15, 0x9d, 0xf1, 0x9c,
+    0xb8, 0x95, 0x56, 0xf5, 0xdb, 0x57, 0x88, 0x9d, 0xdb, 0xe6, 0x75, 0x6b, 0x12, 0x68, 0x34, 0xb1,
+    0xd4, 0xeb, 0x76, 0x72, 0xe0, 0x81, 0x8a, 0x50, 0xdf, 0x2a, 0xc1, 0xc3, 0xd3, 0x1b, 0xa8, 0x81,
+    0x18, 0xde, 0x08, 0x27, 0x77, 0xbb, 0xce, 0x18, 0x8f, 0xcd, 0x5c, 0x34, 0x60, 0xfb, 0x87, 0xfd,
+    0x7a, 0x20, 0x97, 0xdf, 0x7a, 0x21, 0x90, 0xaf, 0xaa, 0x1b, 0x18, 0x74, 0x50, 0xed, 0x92, 0x4e,
+    0x24, 0xf4, 0x3d, 0xfa, 0xea, 0x66, 0xdd, 0x10, 0x6b, 0x6e, 0x80, 0x84, 0x2a, 0xd3, 0xca, 0xd0,
+    0x63, 0x7c, 0x57, 0x4f, 0x1d, 0x73, 0xe4, 0x31, 0xe6, 0x2f, 0x43, 0xbf, 0xcc, 0x1a, 0xb3, 0xb3,
+    0x21, 0x6b, 0xea, 0x5f, 0x74, 0xca, 0xbc, 0xd1, 0x1f, 0xa6, 0xb6, 0x35, 0x8d, 0xe5, 0xc7, 0xa7,
+    0xf2, 0xe7, 0x35, 0x5f, 0x51, 0x73, 0xa0, 0xa7, 0x39, 0x3c, 0xd6, 0xe4, 0xb4, 0x58, 0xfa, 0xe9,
+    0x3d, 0xe1, 0x6e, 0x23, 0xbc, 0xbd, 0x03, 0x65, 0x6a, 0x5f, 0x8f, 0x0a, 0xd8, 0xad, 0x09, 0x25,
+    0xd3, 0xe6, 0xff, 0x5f, 0x08, 0xe4, 0xc2, 0x19, 0x0d, 0xfa, 0xb0, 0x46, 0x25, 0x19, 0x6c, 0x56,
+    0x21, 0x3c, 0xd7, 0xb3, 0xea, 0x83, 0x0d, 0x59, 0xd5, 0x66, 0x6b, 0xf4, 0x77, 0xa9, 0x93, 0xec,
+    0x6f, 0xe0, 0x5c, 0x6b, 0x5b, 0x8e, 0x31, 0xef, 0xda, 0x1f, 0xe1, 0x31, 0x07, 0x9b, 0x4f, 0xbf,
+    0xfa, 0x7f, 0x13, 0xfd, 0x2f, 0x15, 0xae, 0xd3, 0x84, 0x3c, 0x2a, 0x00, 0x00,
+};
+#define HTML_PAGE_ETAG "\"d6f28d35065020fc\""
+// END GENERATED HTML_PAGE
+
+void handleRoot() {
+    server.sendHeader("ETag", HTML_PAGE_ETAG);
+    server.sendHeader("Cache-Control", "no-cache");
+    
+    if(server.header("If-None-Match") == HTML_PAGE_ETAG) {
+        server.send(304);
+        return;
+    }
+    
+    server.sendHeader("Content-Encoding", "gzip");
+    server.send_P(200, "text/html", (const char*)HTML_PAGE_GZ, sizeof(HTML_PAGE_GZ));
+}
+
+/*
+ * Status summary
+ *
+ * Every response carries the current statusRevision, also sent as the ETag.
+ * A client that passes it back (?since=rev or If-None-Match) gets 304 when
+ * nothing changed. Only counts are reported: clients page through
+ * /api/signals when signalsRevision moves and fetch /api/log when logHead
+ * moves.
+ */
+void handleStatus() {
+    uint32_t revision = statusRevision.load(std::memory_order_relaxed);
+    char etag[16];
+    snprintf(etag, sizeof(etag), "\"r%lu\"", (unsigned long)revision);
+    
+    uint32_t since = 0;
+    if(server.hasArg("since")) {
+        since = strtoul(server.arg("since").c_str(), NULL, 10);
+    } else if(server.hasHeader("If-None-Match")) {
+        const char* tag = server.header("If-None-Match").c_str();
+        if(tag[0] == '"' && tag[1] == 'r') since = strtoul(tag + 2, NULL, 10);
+    }
+    
+    server.sendHeader("ETag", etag);
+    server.sendHeader("Cache-Control", "no-cache");
+    
+    if(since == revision) {
+        server.send(304);
+        return;
+    }
+    
+    uint32_t storeRevision = signalsRevision.load(std::memory_order_acquire);
+    SignalStoreMeta meta;
+    readStoreMeta(meta);
+    uint16_t stored = meta.byTime.count;
+    uint16_t storedIR = meta.byType[SIGNAL_TYPE_IR].count;
+    uint16_t storedRF = meta.byType[SIGNAL_TYPE_RF].count;
+    
+    JsonWriter json(server);
+    json.begin();
+    json.beginObject();
+    json.field("revision", revision);
+    
+    // System state
+    json.field("state", activityName());
+    json.field("signalCount", signalCounter.load(std::memory_order_relaxed));
+    json.field("signalsRevision", storeRevision);
+    json.field("stored", stored);
+    json.field("storedIR", storedIR);
+    json.field("storedRF", storedRF);
+    json.field("logDropped", activityLogDropped.load());
+    json.field("logHead", logSequenceBase + activityLogHead.load());
+    
+    json.endObject();
+    json.end();
+}
+
+/*
+ * Signal listing
+ *
+ * GET /api/signals?offset=&limit=&type=IR|RF&from=&to=&sort=asc|desc
+ * from/to bound the capture timestamp (ms, inclusive). Default order is
+ * newest first; limit is capped at SIGNAL_PAGE_MAX.
+ */
+void handleSignals() {
+    int type = -1;
+    if(server.arg("type") == "IR") type = SIGNAL_TYPE_IR;
+    else if(server.arg("type") == "RF") type = SIGNAL_TYPE_RF;
+    
+    unsigned long from = server.hasArg("from") ? strtoul(server.arg("from").c_str(), NULL, 10) : 0;
+    unsigned long to = server.hasArg("to") ? strtoul(server.arg("to").c_str(), NULL, 10) : ULONG_MAX;
+    bool descending = server.arg("sort") != "asc";
+    
+    long offset = server.arg("offset").toInt();
+    long limit = server.hasArg("limit") ? server.arg("limit").toInt() : 20;
+    if(offset < 0) offset = 0;
+    if(limit < 1) limit = 1;
+    if(limit > SIGNAL_PAGE_MAX) limit = SIGNAL_PAGE_MAX;
+    
+    // Read before querying so a concurrent store change is seen as newer
+    uint32_t revision = signalsRevision.load(std::memory_order_acquire);
+    SignalSummary page[SIGNAL_PAGE_MAX];
+    size_t count;
+    size_t total = querySignals(type, from, to, descending, offset, limit, page, count);
+    
+    JsonWriter json(server);
+    json.begin();
+    json.beginObject();
+    json.field("revision", revision);
+    json.field("total", total);
+    json.field("offset", offset);
+    json.beginArray("signals");
+    for(size_t i = 0; i < count; i++) {
+        json.beginObject();
+        json.field("id", page[i].id);
+        json.field("number", page[i].number);
+        json.field("type", page[i].type == SIGNAL_TYPE_IR ? "IR" : "RF");
+        json.field("length", page[i].length);
+        json.field("timestamp", page[i].timestamp);
+        if(page[i].type == SIGNAL_TYPE_IR) {
+            json.field("carrierHz", page[i].carrierHz);
+            json.field("carrierDuty", page[i].carrierDuty);
+        }
+        json.endObject();
+    }
+    json.endArray();
+    json.endObject();
+    json.end();
+}
+
+/*
+ * Raw timings download
+ *
+ * GET /api/signal/{id}/timings returns the timing array as little-endian
+ * uint16 microseconds. The ETag follows the signal revision and a single
+ * "Range: bytes=" range is honoured with 206, so a long capture can be
+ * fetched in slices. The body is sent straight from a copy of the signal.
+ */
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "timings are served in native byte order");
+
+// Parse a single "bytes=first-last" range; false when unsatisfiable
+bool parseByteRange(const char* range, size_t size, size_t& first, size_t& last) {
+    if(strncmp(range, "bytes=", 6) != 0 || strchr(range, ',')) return false;
+    const char* spec = range + 6;
+    char* end;
+    
+    if(*spec == '-') {
+        // Suffix range: the final N bytes
+        unsigned long suffix = strtoul(spec + 1, &end, 10);
+        if(end == spec + 1 || *end || suffix == 0 || size == 0) return false;
+        first = suffix < size ? size - suffix : 0;
+        last = size - 1;
+        return true;
+    }
+    
+    first = strtoul(spec, &end, 10);
+    if(end == spec || *end != '-' || first >= size) return false;
+    spec = end + 1;
+    last = *spec ? strtoul(spec, &end, 10) : size - 1;
+    if((*spec && *end) || last < first) return false;
+    if(last >= size) last = size - 1;
+    return true;
+}
+
+void handleSignalTimings() {
+    static RawSignal signal;
+    if(!copyStoredSignal(server.pathArg(0).c_str(), -1, signal)) {
+        server.send(404, "application/json", "{\"message\":\"Unknown signal\"}");
+        return;
+    }
+    
+    char etag[32];
+    snprintf(etag, sizeof(etag), "\"%s-r%lu\"", signal.id, (unsigned long)signal.revision);
+    server.sendHeader("ETag", etag);
+    server.sendHeader("Accept-Ranges", "bytes");
+    
+    if(server.hasHeader("If-None-Match") && server.header("If-None-Match") == etag) {
+        server.send(304);
+        return;
+    }
+    
+    size_t size = signal.length * sizeof(signal.timings[0]);
+    size_t first = 0, last = size ? size - 1 : 0;
+    int code = 200;
+    char contentRange[48];
+    
+    if(server.hasHeader("Range")) {
+        if(!parseByteRange(server.header("Range").c_str(), size, first, last)) {
+            snprintf(contentRange, sizeof(contentRange), "bytes */%u", (unsigned)size);
+            server.sendHeader("Content-Range", contentRange);
+            server.send(416);
+            return;
+        }
+        snprintf(contentRange, sizeof(contentRange), "bytes %u-%u/%u",
+                 (unsigned)first, (unsigned)last, (unsigned)size);
+        server.sendHeader("Content-Range", contentRange);
+        code = 206;
+    }
+    
+    size_t length = size ? last - first + 1 : 0;
+    server.setContentLength(length);
+    server.send(code, "application/octet-stream", "");
+    if(length) {
+        server.sendContent((const char*)signal.timings + first, length);
+    }
+}
+
+/*
+ * Waveform envelope
+ *
+ * GET /api/signal/{id}/envelope returns ENVELOPE_BUCKETS (min, max) level
+ * byte pairs over the signal duration, enough to draw a preview without the
+ * timings. Envelopes are built on first request and cached by store slot,
+ * tagged with the revision so the next signal to take the slot is never
+ * served a stale one. Cache hits never copy the timings out.
+ */
+struct SignalEnvelope {
+    uint32_t revision;                      // 0 = empty
+    uint8_t levels[ENVELOPE_BUCKETS][2];    // min, max
+};
+
+SignalEnvelope envelopeCache[MAX_STORED_SIGNALS];
+
+// Even timings are the active (high) level, as replayed
+void buildEnvelope(const RawSignal& signal, SignalEnvelope& envelope) {
+    memset(envelope.levels, 0, sizeof(envelope.levels));
+    
+    uint32_t total = 0;
+    for(uint16_t i = 0; i < signal.length; i++) total += signal.timings[i];
+    if(total == 0) return;
+    
+    for(size_t b = 0; b < ENVELOPE_BUCKETS; b++) {
+        envelope.levels[b][0] = 1;
+    }
+    
+    uint32_t start = 0;
+    for(uint16_t i = 0; i < signal.length; i++) {
+        uint32_t end = start + signal.timings[i];
+        if(end > start) {
+            uint8_t level = (i % 2 == 0) ? 1 : 0;
+            size_t first = (uint64_t)start * ENVELOPE_BUCKETS / total;
+            size_t last = (uint64_t)(end - 1) * ENVELOPE_BUCKETS / total;
+            for(size_t b = first; b <= last; b++) {
+                if(level < envelope.levels[b][0]) envelope.levels[b][0] = level;
+                if(level > envelope.levels[b][1]) envelope.levels[b][1] = level;
+            }
+        }
+        start = end;
+    }
+}
+
+void handleSignalEnvelope() {
+    SignalSummary summary;
+    uint16_t slot;
+    if(!findSignalSummary(server.pathArg(0).c_str(), -1, summary, &slot)) {
+        server.send(404, "application/json", "{\"message\":\"Unknown signal\"}");
+        return;
+    }
+    
+    char etag[32];
+    snprintf(etag, sizeof(etag), "\"%s-r%lu-e\"", summary.id, (unsigned long)summary.revision);
+    server.sendHeader("ETag", etag);
+    
+    if(server.hasHeader("If-None-Match") && server.header("If-None-Match") == etag) {
+        server.send(304);
+        return;
+    }
+    
+    SignalEnvelope& envelope = envelopeCache[slot];
+    if(envelope.revision != summary.revision) {
+        static RawSignal signal;
+        if(!copyStoredSignal(summary.id, -1, signal)) {
+            server.send(404, "application/json", "{\"message\":\"Unknown signal\"}");
+            return;
+        }
+        buildEnvelope(signal, envelope);
+        envelope.revision = summary.revision;
     }
     
-    return false;
+    server.setContentLength(sizeof(envelope.levels));
+    server.send(200, "application/octet-stream", "");
+    server.sendContent((const char*)envelope.levels, sizeof(envelope.levels));
 }
 
-void replayRFSignal(const RawSignal& signal) {
-    if(signal.type != SIGNAL_TYPE_RF) return;
+/*
+ * IR carrier setting
+ *
+ * POST /api/signal/{id}/carrier with carrierHz and/or carrierDuty (percent)
+ * overrides the carrier guessed at capture. Omitted fields keep their
+ * value. Responds with the settings now in effect.
+ */
+void handleSignalCarrier() {
+    String id = server.pathArg(0);
+    SignalSummary summary;
+    if(!findSignalSummary(id.c_str(), -1, summary)) {
+        server.send(404, "application/json", "{\"message\":\"Unknown signal\"}");
+        return;
+    }
+    if(summary.type != SIGNAL_TYPE_IR) {
+        server.send(400, "application/json", "{\"message\":\"Only IR signals have a carrier\"}");
+        return;
+    }
     
-    addActivityLog("Replaying RF signal");
+    long carrierHz = server.hasArg("carrierHz") ? server.arg("carrierHz").toInt() : summary.carrierHz;
+    long carrierDuty = server.hasArg("carrierDuty") ? server.arg("carrierDuty").toInt() : summary.carrierDuty;
+    if(carrierHz < IR_CARRIER_MIN_HZ || carrierHz > IR_CARRIER_MAX_HZ ||
+       carrierDuty < IR_CARRIER_MIN_DUTY || carrierDuty > IR_CARRIER_MAX_DUTY) {
+        server.send(400, "application/json", "{\"message\":\"Carrier out of range\"}");
+        return;
+    }
     
-    // Replay the captured RF pattern
-    for(uint16_t i = 0; i < signal.length; i++) {
-        digitalWrite(RF_SEND_PIN, i % 2 == 0 ? HIGH : LOW);
-        delayMicroseconds(signal.timings[i]);
+    if(!setSignalCarrier(id.c_str(), carrierHz, carrierDuty)) {
+        server.send(404, "application/json", "{\"message\":\"Unknown signal\"}");
+        return;
     }
-    digitalWrite(RF_SEND_PIN, LOW);
     
-    char logMsg[64];
-    snprintf(logMsg, sizeof(logMsg), "RF signal replayed: %s", signal.id);
-    addActivityLog(logMsg);
-}
-
-#endif // ENABLE_RF_MODULE
-
-// ============================================================================
-// WEB SERVER HANDLERS
-// ============================================================================
-
-const char HTML_PAGE[] PROGMEM = R"rawliteral(
-<!DOCTYPE html>
-<html>
-<head>
-    <title>ESP32 Security Research Lab</title>
-    <meta name="viewport" content="width=device-width, initial-scale=1">
-    <style>
-        body {
-            font-family: Arial, sans-serif;
-            max-width: 1200px;
-            margin: 0 auto;
-            padding: 20px;
-            background: #f5f5f5;
-        }
-        .header {
-            background: #2c3e50;
-            color: white;
-            padding: 20px;
-            border-radius: 8px;
-            margin-bottom: 20px;
-        }
-        .warning {
-            background: #e74c3c;
-            color: white;
-            padding: 15px;
-            border-radius: 5px;
-            margin-bottom: 20px;
-        }
-        .card {
-            background: white;
-            padding: 20px;
-            border-radius: 8px;
-            margin-bottom: 20px;
-            box-shadow: 0 2px 4px rgba(0,0,0,0.1);
-        }
-        .status {
-            display: inline-block;
-            padding: 5px 15px;
-            border-radius: 20px;
-            font-weight: bold;
-            margin-left: 10px;
-        }
-        .status-idle { background: #95a5a6; color: white; }
-        .status-capturing { background: #f39c12; color: white; }
-        .status-replaying { background: #e74c3c; color: white; }
-        button {
-            background: #3498db;
-            color: white;
-            border: none;
-            padding: 10px 20px;
-            border-radius: 5px;
-            cursor: pointer;
-            font-size: 14px;
-            margin: 5px;
-        }
-        button:hover { background: #2980b9; }
-        button:disabled { background: #bdc3c7; cursor: not-allowed; }
-        .danger { background: #e74c3c; }
-        .danger:hover { background: #c0392b; }
-        .success { background: #27ae60; }
-        .success:hover { background: #229954; }
-        table {
-            width: 100%;
-            border-collapse: collapse;
-        }
-        th, td {
-            padding: 10px;
-            text-align: left;
-            border-bottom: 1px solid #ddd;
-        }
-        th { background: #34495e; color: white; }
-        .log-entry {
-            padding: 5px;
-            margin: 2px 0;
-            background: #ecf0f1;
-            border-left: 3px solid #3498db;
-            font-family: monospace;
-            font-size: 12px;
-        }
-        input[type="number"] {
-            padding: 8px;
-            border: 1px solid #ddd;
-            border-radius: 4px;
-            width: 100px;
-        }
-    </style>
-</head>
-<body>
-    <div class="header">
-        <h1>🔒 ESP32 Hardware Security Research Lab</h1>
-        <p>Educational Demonstration of Insecure Signal Design Vulnerabilities</p>
-        <div>
-            Status: <span class="status status-idle" id="systemStatus">IDLE</span>
-            Signal Count: <strong id="signalCount">0</strong>
-        </div>
-    </div>
-
-    <div class="warning">
-        ⚠️ <strong>EDUCATIONAL USE ONLY</strong> - This system demonstrates why legacy IR/RF systems 
-        without authentication are vulnerable to replay attacks. Modern secure systems use rolling codes 
-        and encryption to prevent these attacks. Use only on devices you own in a controlled lab environment.
-    </div>
-
-    <div class="card">
-        <h2>📡 Signal Capture</h2>
-        <p>Capture IR or RF signals from insecure devices. This demonstrates why authentication is critical.</p>
-        <button onclick="captureSignal('IR')" id="btnCaptureIR">Capture IR Signal</button>
-        <button onclick="captureSignal('RF')" id="btnCaptureRF">Capture RF Signal</button>
-    </div>
-
-    <div class="card">
-        <h2>📋 Captured Signals</h2>
-        <table id="signalTable">
-            <thead>
-                <tr>
-                    <th>ID</th>
-                    <th>Type</th>
-                    <th>Length</th>
-                    <th>Timestamp</th>
-                    <th>Action</th>
-                </tr>
-            </thead>
-            <tbody id="signalTableBody">
-                <tr><td colspan="5" style="text-align:center;">No signals captured</td></tr>
-            </tbody>
-        </table>
-    </div>
-
-    <div class="card">
-        <h2>🎯 Attack Simulation Mode</h2>
-        <p>Demonstrates sequential replay attacks on insecure systems. Includes failsafe timeout protection.</p>
-        <div>
-            <label>Delay between replays (ms): </label>
-            <input type="number" id="attackDelay" value="1000" min="500" max="10000" step="100">
-        </div>
-        <div style="margin-top: 10px;">
-            <button onclick="startAttackSim()" class="danger" id="btnStartAttack">Start Sequential Replay</button>
-            <button onclick="stopAttackSim()" class="success" id="btnStopAttack">Stop Simulation</button>
-        </div>
-    </div>
-
-    <div class="card">
-        <h2>📊 Activity Log</h2>
-        <div id="activityLog" style="max-height: 300px; overflow-y: auto;">
-            <div class="log-entry">System initialized</div>
-        </div>
-    </div>
-
-    <div class="card">
-        <h2>ℹ️ Security Concepts</h2>
-        <h3>Why Replay Attacks Work on Insecure Systems:</h3>
-        <ul>
-            <li><strong>No Authentication:</strong> Device accepts any valid timing pattern</li>
-            <li><strong>Static Codes:</strong> Same signal transmitted every time</li>
-            <li><strong>No Encryption:</strong> Signals transmitted in plain form</li>
-        </ul>
-        <h3>How Secure Systems Prevent This:</h3>
-        <ul>
-            <li><strong>Rolling Codes:</strong> Code changes with each transmission</li>
-            <li><strong>Challenge-Response:</strong> Requires cryptographic handshake</li>
-            <li><strong>Encryption:</strong> AES or similar protects command data</li>
-            <li><strong>Timestamps:</strong> Prevents replay of old signals</li>
-        </ul>
-    </div>
-
-    <script>
-        function updateStatus() {
-            fetch('/api/status')
-                .then(r => r.json())
-                .then(data => {
-                    document.getElementById('systemStatus').textContent = data.state;
-                    document.getElementById('systemStatus').className = 'status status-' + data.state.toLowerCase();
-                    document.getElementById('signalCount').textContent = data.signalCount;
-                    
-                    updateSignalTable(data.signals);
-                    updateActivityLog(data.log);
-                });
-        }
-
-        function updateSignalTable(signals) {
-            const tbody = document.getElementById('signalTableBody');
-            if(signals.length === 0) {
-                tbody.innerHTML = '<tr><td colspan="5" style="text-align:center;">No signals captured</td></tr>';
-                return;
-            }
-            
-            tbody.innerHTML = signals.map((s, idx) => 
-                `<tr>
-                    <td>${s.id}</td>
-                    <td>${s.type}</td>
-                    <td>${s.length}</td>
-                    <td>${s.timestamp}</td>
-                    <td><button onclick="replaySignal(${idx})">Replay</button></td>
-                </tr>`
-            ).join('');
-        }
-
-        function updateActivityLog(log) {
-            const logDiv = document.getElementById('activityLog');
-            logDiv.innerHTML = log.map(entry => 
-                `<div class="log-entry">[${entry.timestamp}] ${entry.message}</div>`
-            ).reverse().join('');
-        }
-
-        function captureSignal(type) {
-            fetch('/api/capture?type=' + type)
-                .then(r => r.json())
-                .then(data => {
-                    alert(data.message);
-                    updateStatus();
-                });
-        }
-
-        function replaySignal(index) {
-            fetch('/api/replay?index=' + index)
-                .then(r => r.json())
-                .then(data => {
-                    alert(data.message);
-                    updateStatus();
-                });
-        }
-
-        function startAttackSim() {
-            const delay = document.getElementById('attackDelay').value;
-            fetch('/api/attack/start?delay=' + delay)
-                .then(r => r.json())
-                .then(data => {
-                    alert(data.message);
-                    updateStatus();
-                });
-        }
-
-        function stopAttackSim() {
-            fetch('/api/attack/stop')
-                .then(r => r.json())
-                .then(data => {
-                    alert(data.message);
-                    updateStatus();
-                });
-        }
-
-        // Update status every 2 seconds
-        setInterval(updateStatus, 2000);
-        updateStatus();
-    </script>
-</body>
-</html>
-)rawliteral";
-
-void handleRoot() {
-    server.send(200, "text/html", HTML_PAGE);
+    JsonWriter json(server);
+    json.begin();
+    json.beginObject();
+    json.field("id", summary.id);
+    json.field("carrierHz", (uint32_t)carrierHz);
+    json.field("carrierDuty", (uint32_t)carrierDuty);
+    json.endObject();
+    json.end();
 }
 
-void handleStatus() {
-    String json = "{";
+/*
+ * Incremental activity log retrieval
+ *
+ * GET /api/log?since=N returns entries with sequence > N, oldest first,
+ * reading from the RAM ring when possible and from the flash segments for
+ * older history. Without since, the last MAX_LOG_ENTRIES are returned.
+ * "last" is the sequence to pass as since on the next request; it is
+ * absent while the log is still empty.
+ */
+void handleLog() {
+    uint32_t head = activityLogHead.load(std::memory_order_acquire);
+    uint32_t end = logSequenceBase + head;
+    uint32_t ringOldest = logSequenceBase + (head > LOG_RING_SLOTS ? head - LOG_RING_SLOTS : 0);
     
-    // System state
-    const char* stateName[] = {"IDLE", "CAPTURING", "REPLAYING"};
-    json += "\"state\":\"" + String(stateName[currentState]) + "\",";
-    json += "\"signalCount\":" + String(signalCounter) + ",";
+    uint32_t from;
+    if(server.hasArg("since")) {
+        from = strtoul(server.arg("since").c_str(), NULL, 10) + 1;
+    } else {
+        from = end > MAX_LOG_ENTRIES ? end - MAX_LOG_ENTRIES : 0;
+    }
+    
+    size_t limit = LOG_API_MAX_ENTRIES;
+    if(server.hasArg("limit")) {
+        long requested = server.arg("limit").toInt();
+        if(requested > 0 && requested < LOG_API_MAX_ENTRIES) limit = requested;
+    }
     
-    // Signals array
-    json += "\"signals\":[";
-    for(size_t i = 0; i < capturedSignals.size(); i++) {
-        if(i > 0) json += ",";
-        json += "{";
-        json += "\"id\":\"" + String(capturedSignals[i].id) + "\",";
-        json += "\"type\":\"" + String(capturedSignals[i].type == SIGNAL_TYPE_IR ? "IR" : "RF") + "\",";
-        json += "\"length\":" + String(capturedSignals[i].length) + ",";
-        json += "\"timestamp\":" + String(capturedSignals[i].timestamp);
-        json += "}";
+    static PersistedLogRecord records[LOG_API_MAX_ENTRIES];
+    size_t count = 0;
+    
+    // Older history comes from flash
+    if(from < ringOldest && logStoreReady) {
+        count = readPersistedLog(from, records, limit);
+        if(count > 0) from = records[count - 1].sequence + 1;
     }
-    json += "],";
+    if(from < ringOldest) from = ringOldest;
     
-    // Activity log
-    json += "\"log\":[";
-    for(size_t i = 0; i < activityLog.size(); i++) {
-        if(i > 0) json += ",";
-        json += "{";
-        json += "\"timestamp\":" + String(activityLog[i].timestamp) + ",";
-        json += "\"message\":\"" + String(activityLog[i].message) + "\"";
-        json += "}";
+    // Everything newer comes from the RAM ring
+    for(uint32_t sequence = from; sequence < end && count < limit; sequence++) {
+        LogSlotStatus status = readActivityLogSlot(sequence - logSequenceBase, records[count].entry);
+        if(status == LOG_SLOT_PENDING) {
+            end = sequence; // Not published yet; pick it up next time
+            break;
+        }
+        if(status == LOG_SLOT_READY) {
+            records[count].sequence = sequence;
+            count++;
+        }
     }
-    json += "]";
     
-    json += "}";
+    // An empty log has no sequence to resume from; "last" is left out so
+    // the client keeps its cursor rather than skipping entry 0
+    bool empty = (count == 0 && end == 0);
+    uint32_t last = 0;
+    if(count == limit) last = records[count - 1].sequence;
+    else if(!empty) last = end - 1;
     
-    server.send(200, "application/json", json);
+    JsonWriter json(server);
+    json.begin();
+    json.beginObject();
+    if(!empty) json.field("last", last);
+    json.beginArray("entries");
+    for(size_t i = 0; i < count; i++) {
+        char message[64];
+        formatActivityLog(records[i].entry, message, sizeof(message));
+        
+        json.beginObject();
+        json.field("seq", records[i].sequence);
+        json.field("timestamp", records[i].entry.timestamp);
+        json.field("message", message);
+        json.endObject();
+    }
+    json.endArray();
+    json.endObject();
+    json.end();
 }
 
+/*
+ * Capture submission
+ *
+ * POST /api/capture?type=IR|RF queues a capture job and answers 202 with
+ * its id straight away. Progress is available from /api/jobs/{id} and as
+ * "job" events on /api/events.
+ */
 void handleCapture() {
-    if(currentState != STATE_IDLE) {
-        server.send(400, "application/json", "{\"message\":\"System busy\"}");
-        return;
-    }
-    
     String type = server.arg("type");
-    RawSignal signal;
-    bool success = false;
-    
-    currentState = STATE_CAPTURING;
-    stateStartTime = millis();
+    SignalType signalType;
     
     if(type == "IR") {
         #if ENABLE_IR_MODULE
-        success = captureIRSignal(signal);
+        signalType = SIGNAL_TYPE_IR;
         #else
         server.send(400, "application/json", "{\"message\":\"IR module disabled\"}");
-        currentState = STATE_IDLE;
         return;
         #endif
     } else if(type == "RF") {
         #if ENABLE_RF_MODULE
-        success = captureRFSignal(signal);
+        signalType = SIGNAL_TYPE_RF;
         #else
         server.send(400, "application/json", "{\"message\":\"RF module disabled\"}");
-        currentState = STATE_IDLE;
         return;
         #endif
+    } else {
+        server.send(400, "application/json", "{\"message\":\"Unknown signal type\"}");
+        return;
     }
     
-    currentState = STATE_IDLE;
-    
-    if(success) {
-        if(capturedSignals.size() >= MAX_STORED_SIGNALS) {
-            capturedSignals.erase(capturedSignals.begin());
-        }
-        capturedSignals.push_back(signal);
-        
-        String msg = "{\"message\":\"Signal captured: " + String(signal.id) + "\"}";
-        server.send(200, "application/json", msg);
-    } else {
-        server.send(400, "application/json", "{\"message\":\"Capture failed or timeout\"}");
+    Job* job = submitJob(JOB_CAPTURE, signalType, PRIORITY_INTERACTIVE, 0, NULL);
+    if(!job) {
+        LOG_EVENT(EVT_HTTP_BUSY);
+        server.send(503, "application/json", "{\"message\":\"Job queue full\"}");
+        return;
     }
+    
+    char response[64];
+    snprintf(response, sizeof(response), "{\"job\":%lu,\"message\":\"Capture queued\"}", (unsigned long)job->id);
+    server.send(202, "application/json", response);
 }
 
-void handleReplay() {
-    if(currentState != STATE_IDLE) {
-        server.send(400, "application/json", "{\"message\":\"System busy\"}");
+// GET /api/jobs/{id}
+void handleJob() {
+    lockJobs();
+    Job* job = findJob(strtoul(server.pathArg(0).c_str(), NULL, 10));
+    if(!job) {
+        unlockJobs();
+        server.send(404, "application/json", "{\"message\":\"Unknown job\"}");
         return;
     }
     
-    int index = server.arg("index").toInt();
+    uint32_t id = job->id;
+    JobKind kind = job->kind;
+    JobPriority priority = job->priority;
+    SignalType type = job->type;
+    JobStatus status = job->status;
+    char signalId[16];
+    memcpy(signalId, job->signalId, sizeof(signalId));
+    SelfTestResult selfTest = job->selfTest;
+    int16_t markTrimUs = job->markTrimUs;
+    int16_t spaceTrimUs = job->spaceTrimUs;
+    unlockJobs();
+    bool graded = (kind == JOB_SELFTEST || kind == JOB_CALIBRATE) && status == JOB_DONE;
     
-    if(index < 0 || index >= capturedSignals.size()) {
+    JsonWriter json(server);
+    json.begin();
+    json.beginObject();
+    json.field("id", id);
+    json.field("kind", JOB_KIND_NAMES[kind]);
+    json.field("type", type == SIGNAL_TYPE_IR ? "IR" : "RF");
+    json.field("priority", JOB_PRIORITY_NAMES[priority]);
+    json.field("status", JOB_STATUS_NAMES[status]);
+    if(kind != JOB_CAPTURE || status == JOB_DONE) {
+        json.field("signal", signalId);
+    }
+    if(graded) {
+        json.beginObject("selftest");
+        json.field("passed", selfTest.passed);
+        json.field("edges", selfTest.edges);
+        json.field("missing", selfTest.missing);
+        json.field("extra", selfTest.extra);
+        json.field("outliers", selfTest.outliers);
+        json.field("shift", selfTest.shift);
+        json.field("markErrorUs", selfTest.markErrorUs);
+        json.field("spaceErrorUs", selfTest.spaceErrorUs);
+        json.field("meanAbsErrorUs", selfTest.meanAbsErrorUs);
+        json.field("maxAbsErrorUs", selfTest.maxAbsErrorUs);
+        json.field("worstEdge", selfTest.worstEdge);
+        json.endObject();
+    }
+    if(graded && kind == JOB_CALIBRATE) {
+        json.beginObject("calibration");
+        json.field("markTrimUs", (int32_t)markTrimUs);
+        json.field("spaceTrimUs", (int32_t)spaceTrimUs);
+        json.endObject();
+    }
+    json.endObject();
+    json.end();
+}
+
+/*
+ * Loopback self-test and output calibration
+ *
+ * POST /api/selftest?id= (or index=) queues a self-test of a stored
+ * signal and answers 202 with the job id. /api/jobs/{id} carries the
+ * grade once the job is done; it fails if no echo came back.
+ *
+ * POST /api/calibrate takes the same arguments and runs a self-test that
+ * updates the output calibration of the signal's transmitter; the job
+ * also reports the trims it left, and fails if too little of the echo
+ * came back to calibrate from.
+ */
+void queueSelfTest(JobKind kind, const char* message) {
+    String id = server.arg("id");
+    SignalSummary target;
+    if(!findSignalSummary(server.hasArg("id") ? id.c_str() : NULL, server.arg("index").toInt(), target)) {
         server.send(400, "application/json", "{\"message\":\"Invalid signal index\"}");
         return;
     }
     
-    currentState = STATE_REPLAYING;
-    stateStartTime = millis();
+    Job* job = submitJob(kind, target.type, PRIORITY_INTERACTIVE, 0, target.id);
+    if(!job) {
+        LOG_EVENT(EVT_HTTP_BUSY);
+        server.send(503, "application/json", "{\"message\":\"Job queue full\"}");
+        return;
+    }
     
-    const RawSignal& signal = capturedSignals[index];
+    char response[64];
+    snprintf(response, sizeof(response), "{\"job\":%lu,\"message\":\"%s\"}", (unsigned long)job->id, message);
+    server.send(202, "application/json", response);
+}
+
+void handleSelfTest() {
+    queueSelfTest(JOB_SELFTEST, "Self-test queued");
+}
+
+void handleCalibrate() {
+    queueSelfTest(JOB_CALIBRATE, "Calibration queued");
+}
+
+// POST /api/jobs/{id}/cancel
+void handleJobCancel() {
+    if(!cancelJob(strtoul(server.pathArg(0).c_str(), NULL, 10))) {
+        server.send(404, "application/json", "{\"message\":\"No such active job\"}");
+        return;
+    }
     
-    if(signal.type == SIGNAL_TYPE_IR) {
-        #if ENABLE_IR_MODULE
-        replayIRSignal(signal);
-        #endif
-    } else {
-        #if ENABLE_RF_MODULE
-        replayRFSignal(signal);
-        #endif
+    server.send(202, "application/json", "{\"message\":\"Cancel requested\"}");
+}
+
+/*
+ * Replay submission
+ *
+ * POST /api/replay?id= (or index=) queues a replay and answers 202 with
+ * its id, like /api/capture. The job expires if the transmitter is not
+ * free within REPLAY_START_DEADLINE_MS; the outcome is available from
+ * /api/jobs/{id} and as "job" events on /api/events.
+ */
+void handleReplay() {
+    String id = server.arg("id");
+    SignalSummary target;
+    if(!findSignalSummary(server.hasArg("id") ? id.c_str() : NULL, server.arg("index").toInt(), target)) {
+        server.send(400, "application/json", "{\"message\":\"Invalid signal index\"}");
+        return;
     }
     
-    currentState = STATE_IDLE;
+    Job* job = submitJob(JOB_REPLAY, target.type, PRIORITY_INTERACTIVE, REPLAY_START_DEADLINE_MS, target.id);
+    if(!job) {
+        LOG_EVENT(EVT_HTTP_BUSY);
+        server.send(503, "application/json", "{\"message\":\"Job queue full\"}");
+        return;
+    }
     
-    server.send(200, "application/json", "{\"message\":\"Signal replayed\"}");
+    char response[64];
+    snprintf(response, sizeof(response), "{\"job\":%lu,\"message\":\"Replay queued\"}", (unsigned long)job->id);
+    server.send(202, "application/json", response);
 }
 
 void handleAttackStart() {
-    if(capturedSignals.empty()) {
+    if(storedSignalCount() == 0) {
         server.send(400, "application/json", "{\"message\":\"No signals to replay\"}");
         return;
     }
@@ -728,29 +3597,493 @@ void handleAttackStart() {
     if(attackDelayMs < 500) attackDelayMs = 500;
     if(attackDelayMs > 10000) attackDelayMs = 10000;
     
+    attackRun.fetch_add(1);
     attackSimulationActive = true;
-    attackSignalIndex = 0;
-    lastAttackTime = 0;
-    stateStartTime = millis();
+    statusRevision.fetch_add(1, std::memory_order_relaxed);
+    wakeLoopTask();
     
-    addActivityLog("Attack simulation started");
+    LOG_EVENT(EVT_ATTACK_STARTED);
     
     server.send(200, "application/json", "{\"message\":\"Attack simulation started\"}");
 }
 
 void handleAttackStop() {
     attackSimulationActive = false;
-    currentState = STATE_IDLE;
+    statusRevision.fetch_add(1, std::memory_order_relaxed);
+    cancelJobs(PRIORITY_BACKGROUND);
+    wakeLoopTask();
     
-    addActivityLog("Attack simulation stopped");
+    LOG_EVENT(EVT_ATTACK_STOPPED);
     
     server.send(200, "application/json", "{\"message\":\"Attack simulation stopped\"}");
 }
 
+// ============================================================================
+// SERVER-SENT EVENTS
+// ============================================================================
+
+/*
+ * Push channel (GET /api/events)
+ *
+ * Subscribers receive "status" events when statusRevision moves, one
+ * "signal" event per newly stored signal and one "log" event per log entry.
+ * Each subscriber is tracked as cursors (last revision, last signal
+ * revision, next log sequence) plus a small pending byte buffer, so a slow
+ * client only ever costs EVENT_CLIENT_BUFFER bytes: status updates coalesce
+ * to the latest, and a client whose log cursor is overtaken by the ring gets
+ * a "resync" event and re-fetches over the REST endpoints. Sockets are
+ * written with MSG_DONTWAIT so a stalled client never blocks loop().
+ */
+struct EventClient {
+    bool active;
+    WiFiClient client;
+    char pending[EVENT_CLIENT_BUFFER];
+    size_t pendingLength;
+    uint32_t revision;          // statusRevision last sent
+    uint32_t signalsRevision;   // Revision of the newest signal sent
+    uint32_t jobsRevision;      // Newest job transition sent
+    uint32_t logCursor;         // Next log sequence to send
+    unsigned long lastStatus;
+    unsigned long lastSend;
+};
+
+EventClient eventClients[MAX_EVENT_CLIENTS];
+
+void handleEvents() {
+    EventClient* slot = NULL;
+    for(size_t i = 0; i < MAX_EVENT_CLIENTS; i++) {
+        if(!eventClients[i].active) {
+            slot = &eventClients[i];
+            break;
+        }
+    }
+    
+    if(!slot) {
+        server.send(503, "application/json", "{\"message\":\"Too many event subscribers\"}");
+        return;
+    }
+    
+    slot->client = server.client();
+    slot->client.print("HTTP/1.1 200 OK\r\n"
+                       "Content-Type: text/event-stream\r\n"
+                       "Cache-Control: no-cache\r\n"
+                       "Connection: keep-alive\r\n\r\n"
+                       "retry: 2000\n\n");
+    slot->active = true;
+    slot->pendingLength = 0;
+    slot->revision = 0;
+    slot->signalsRevision = signalsRevision;
+    slot->jobsRevision = jobsRevision.load(std::memory_order_relaxed);
+    slot->logCursor = logSequenceBase + activityLogHead.load(std::memory_order_acquire);
+    slot->lastStatus = 0;
+    slot->lastSend = millis();
+    
+    // Our copy keeps the socket open; the server drops its reference
+    server.client().stop();
+}
+
+void closeEventClient(EventClient& ec) {
+    ec.client.stop();
+    ec.active = false;
+    ec.pendingLength = 0;
+}
+
+// Append one formatted event if it fits; false leaves it for a later pass
+bool queueEvent(EventClient& ec, const char* event, const char* data) {
+    size_t room = sizeof(ec.pending) - ec.pendingLength;
+    int length = snprintf(ec.pending + ec.pendingLength, room, "event: %s\ndata: %s\n\n", event, data);
+    if(length < 0 || (size_t)length >= room) {
+        return false;
+    }
+    ec.pendingLength += length;
+    return true;
+}
+
+void fillEventClient(EventClient& ec, unsigned long now) {
+    char data[160];
+    
+    // Status: coalesced, only the latest revision is ever sent
+    uint32_t revision = statusRevision.load(std::memory_order_relaxed);
+    if(revision != ec.revision && now - ec.lastStatus >= EVENT_STATUS_INTERVAL_MS) {
+        snprintf(data, sizeof(data),
+                 "{\"revision\":%lu,\"state\":\"%s\",\"signalCount\":%lu,\"signalsRevision\":%lu,\"stored\":%u,\"logDropped\":%lu,\"logHead\":%lu}",
+                 (unsigned long)revision, activityName(), (unsigned long)signalCounter.load(std::memory_order_relaxed),
+                 (unsigned long)signalsRevision, (unsigned)storedSignalCount(),
+                 (unsigned long)activityLogDropped.load(),
+                 (unsigned long)(logSequenceBase + activityLogHead.load()));
+        if(!queueEvent(ec, "status", data)) return;
+        ec.revision = revision;
+        ec.lastStatus = now;
+    }
+    
+    // Signals stored or changed since the last one sent
+    uint32_t storeRevision = signalsRevision.load(std::memory_order_acquire);
+    if(ec.signalsRevision != storeRevision) {
+        SignalSummary summaries[MAX_STORED_SIGNALS];
+        size_t count = snapshotSignals(ec.signalsRevision, summaries);
+        
+        for(size_t i = 0; i < count; i++) {
+            const SignalSummary& signal = summaries[i];
+            snprintf(data, sizeof(data),
+                     "{\"id\":\"%s\",\"number\":%lu,\"type\":\"%s\",\"length\":%u,\"timestamp\":%lu,\"carrierHz\":%lu,\"carrierDuty\":%u}",
+                     signal.id, (unsigned long)signal.number,
+                     signal.type == SIGNAL_TYPE_IR ? "IR" : "RF",
+                     signal.length, signal.timestamp,
+                     (unsigned long)signal.carrierHz, (unsigned)signal.carrierDuty);
+            if(!queueEvent(ec, "signal", data)) return;
+            ec.signalsRevision = signal.changed;
+        }
+        // Changes to signals evicted since then leave nothing to send
+        if((int32_t)(storeRevision - ec.signalsRevision) > 0) ec.signalsRevision = storeRevision;
+    }
+    
+    // Job transitions since the last one sent
+    if(ec.jobsRevision != jobsRevision.load(std::memory_order_relaxed)) {
+        uint32_t newest = ec.jobsRevision;
+        bool queued = true;
+        
+        lockJobs();
+        for(size_t i = 0; i < MAX_JOBS && queued; i++) {
+            const Job& job = jobs[i];
+            if(job.id == 0 || job.revision <= ec.jobsRevision) continue;
+            
+            snprintf(data, sizeof(data), "{\"id\":%lu,\"kind\":\"%s\",\"status\":\"%s\",\"signal\":\"%s\"}",
+                     (unsigned long)job.id, JOB_KIND_NAMES[job.kind], JOB_STATUS_NAMES[job.status],
+                     (job.kind != JOB_CAPTURE || job.status == JOB_DONE) ? job.signalId : "");
+            queued = queueEvent(ec, "job", data);
+            if(queued && job.revision > newest) newest = job.revision;
+        }
+        unlockJobs();
+        
+        if(!queued) return;
+        ec.jobsRevision = newest;
+    }
+    
+    // Log entries, resyncing if the ring has overtaken this client
+    uint32_t head = activityLogHead.load(std::memory_order_acquire);
+    uint32_t ringOldest = logSequenceBase + (head > LOG_RING_SLOTS ? head - LOG_RING_SLOTS : 0);
+    if(ec.logCursor < ringOldest) {
+        if(!queueEvent(ec, "resync", "{}")) return;
+        ec.logCursor = logSequenceBase + head;
+    }
+    
+    while(ec.logCursor < logSequenceBase + head) {
+        ActivityLogEntry entry;
+        LogSlotStatus status = readActivityLogSlot(ec.logCursor - logSequenceBase, entry);
+        if(status == LOG_SLOT_PENDING) break;
+        
+        if(status == LOG_SLOT_READY) {
+            char message[64];
+            formatActivityLog(entry, message, sizeof(message));
+            snprintf(data, sizeof(data), "{\"seq\":%lu,\"timestamp\":%lu,\"message\":\"%s\"}",
+                     (unsigned long)ec.logCursor, (unsigned long)entry.timestamp, message);
+            if(!queueEvent(ec, "log", data)) return;
+        }
+        ec.logCursor++;
+    }
+}
+
+// Called from loop(): refill and flush every subscriber without blocking
+void pumpEventClients() {
+    unsigned long now = millis();
+    
+    for(size_t i = 0; i < MAX_EVENT_CLIENTS; i++) {
+        EventClient& ec = eventClients[i];
+        if(!ec.active) continue;
+        
+        if(!ec.client.connected()) {
+            closeEventClient(ec);
+            continue;
+        }
+        
+        fillEventClient(ec, now);
+        
+        if(ec.pendingLength == 0 && now - ec.lastSend >= EVENT_KEEPALIVE_MS) {
+            static const char keepalive[] = ": keepalive\n\n";
+            memcpy(ec.pending, keepalive, sizeof(keepalive) - 1);
+            ec.pendingLength = sizeof(keepalive) - 1;
+        }
+        
+        if(ec.pendingLength > 0) {
+            int sent = send(ec.client.fd(), ec.pending, ec.pendingLength, MSG_DONTWAIT);
+            if(sent < 0) {
+                if(errno != EAGAIN && errno != EWOULDBLOCK) closeEventClient(ec);
+                continue;
+            }
+            memmove(ec.pending, ec.pending + sent, ec.pendingLength - sent);
+            ec.pendingLength -= sent;
+            ec.lastSend = now;
+        }
+    }
+}
+
+// ============================================================================
+// METRICS
+// ============================================================================
+
+/*
+ * Prometheus text exposition
+ *
+ * GET /metrics reports the counters and histograms in Metrics plus heap,
+ * log and WiFi gauges. Values are read with relaxed loads while writers
+ * keep counting, so a histogram's count is taken as the sum of the bucket
+ * values read, keeping each histogram self-consistent.
+ */
+class MetricsWriter {
+public:
+    explicit MetricsWriter(WebServer& server) : server(server) {}
+    
+    void begin() {
+        server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+        server.send(200, "text/plain; version=0.0.4", "");
+    }
+    
+    void end() {
+        flush();
+    }
+    
+    void describe(const char* name, const char* type, const char* help) {
+        print("# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+    }
+    
+    void value(const char* name, unsigned long value) {
+        print("%s %lu\n", name, value);
+    }
+    
+    // Signed sample with labels, e.g. type="IR"
+    void value(const char* name, const char* labels, long value) {
+        print("%s{%s} %ld\n", name, labels, value);
+    }
+    
+    // Samples of one histogram; labels is either empty or ends with a comma
+    void histogram(const char* name, const char* labels, const LatencyHistogram& histogram) {
+        unsigned long count = 0;
+        for(size_t i = 0; i <= LATENCY_BUCKETS; i++) {
+            count += histogram.buckets[i].load(std::memory_order_relaxed);
+            print("%s_bucket{%sle=\"%s\"} %lu\n", name, labels,
+                  i < LATENCY_BUCKETS ? LATENCY_BOUNDS_LABEL[i] : "+Inf", count);
+        }
+        uint64_t sum = histogram.sumMicros.load(std::memory_order_relaxed);
+        const char* open = labels[0] ? "{" : "";
+        const char* close = labels[0] ? "}" : "";
+        size_t labelsLength = labels[0] ? strlen(labels) - 1 : 0;
+        print("%s_sum%s%.*s%s %llu.%06lu\n", name, open, (int)labelsLength, labels, close,
+              (unsigned long long)(sum / 1000000), (unsigned long)(sum % 1000000));
+        print("%s_count%s%.*s%s %lu\n", name, open, (int)labelsLength, labels, close, count);
+    }
+    
+private:
+    WebServer& server;
+    char buffer[METRICS_BUFFER_SIZE];
+    size_t used = 0;
+    
+    void flush() {
+        if(used > 0) {
+            server.sendContent(buffer, used);
+            used = 0;
+        }
+    }
+    
+    void print(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+        for(int attempt = 0; attempt < 2; attempt++) {
+            va_list args;
+            va_start(args, format);
+            int length = vsnprintf(buffer + used, sizeof(buffer) - used, format, args);
+            va_end(args);
+            if(length >= 0 && (size_t)length < sizeof(buffer) - used) {
+                used += length;
+                return;
+            }
+            flush();
+        }
+    }
+};
+
+void handleMetrics() {
+    MetricsWriter out(server);
+    out.begin();
+    
+    out.describe("seclab_loop_duration_seconds", "histogram", "Time spent per loop() iteration, excluding the idle delay");
+    out.histogram("seclab_loop_duration_seconds", "", metrics.loopLatency);
+    
+    out.describe("seclab_http_request_duration_seconds", "histogram", "HTTP handler latency by route");
+    for(size_t i = 0; i < ENDPOINT_COUNT; i++) {
+        char labels[48];
+        snprintf(labels, sizeof(labels), "endpoint=\"%s\",", ENDPOINT_NAMES[i]);
+        out.histogram("seclab_http_request_duration_seconds", labels, metrics.endpointLatency[i]);
+    }
+    
+    out.describe("seclab_captures_total", "counter", "Capture attempts");
+    out.value("seclab_captures_total", metrics.captures.load(std::memory_order_relaxed));
+    out.describe("seclab_captures_succeeded_total", "counter", "Captures that produced a stored signal");
+    out.value("seclab_captures_succeeded_total", metrics.capturesSucceeded.load(std::memory_order_relaxed));
+    out.describe("seclab_captures_failed_total", "counter", "Captures without a valid signal");
+    out.value("seclab_captures_failed_total", metrics.capturesFailed.load(std::memory_order_relaxed));
+    out.describe("seclab_capture_edges_total", "counter", "Edges recorded by captures");
+    out.value("seclab_capture_edges_total", metrics.edgesCaptured.load(std::memory_order_relaxed));
+    out.describe("seclab_capture_edges_filtered_total", "counter", "Edges dropped by the pulse width filter");
+    out.value("seclab_capture_edges_filtered_total", metrics.edgesFiltered.load(std::memory_order_relaxed));
+    out.describe("seclab_replays_total", "counter", "Signal replays");
+    out.value("seclab_replays_total", metrics.replays.load(std::memory_order_relaxed));
+    out.describe("seclab_program_cache_hits_total", "counter", "Replays sent from a cached RMT program");
+    out.value("seclab_program_cache_hits_total", metrics.programCacheHits.load(std::memory_order_relaxed));
+    out.describe("seclab_program_cache_misses_total", "counter", "Replays that compiled their RMT program");
+    out.value("seclab_program_cache_misses_total", metrics.programCacheMisses.load(std::memory_order_relaxed));
+    out.describe("seclab_program_cache_bytes", "gauge", "Heap held by cached RMT programs");
+    out.value("seclab_program_cache_bytes", programCacheBytes.load(std::memory_order_relaxed));
+    out.describe("seclab_tx_mark_trim_us", "gauge", "Output calibration added to replayed marks");
+    out.value("seclab_tx_mark_trim_us", "type=\"IR\"", transmitters[SIGNAL_TYPE_IR].markTrimUs.load(std::memory_order_relaxed));
+    out.value("seclab_tx_mark_trim_us", "type=\"RF\"", transmitters[SIGNAL_TYPE_RF].markTrimUs.load(std::memory_order_relaxed));
+    out.describe("seclab_tx_space_trim_us", "gauge", "Output calibration added to replayed spaces");
+    out.value("seclab_tx_space_trim_us", "type=\"IR\"", transmitters[SIGNAL_TYPE_IR].spaceTrimUs.load(std::memory_order_relaxed));
+    out.value("seclab_tx_space_trim_us", "type=\"RF\"", transmitters[SIGNAL_TYPE_RF].spaceTrimUs.load(std::memory_order_relaxed));
+    
+    out.describe("seclab_heap_free_bytes", "gauge", "Free heap");
+    out.value("seclab_heap_free_bytes", ESP.getFreeHeap());
+    out.describe("seclab_heap_largest_free_block_bytes", "gauge", "Largest allocatable heap block");
+    out.value("seclab_heap_largest_free_block_bytes", heap_caps_get_largest_free_block(MALLOC_CAP_8BIT));
+    out.describe("seclab_log_dropped_total", "counter", "Activity log messages dropped");
+    out.value("seclab_log_dropped_total", activityLogDropped.load(std::memory_order_relaxed));
+    out.describe("seclab_wifi_clients", "gauge", "Stations connected to the access point");
+    out.value("seclab_wifi_clients", WiFi.softAPgetStationNum());
+    
+    out.end();
+}
+
+// Route wrapper recording the handler's latency under its endpoint
+template<HttpEndpoint endpoint, void (*handler)()>
+void metered() {
+    uint32_t start = micros();
+    handler();
+    metrics.endpointLatency[endpoint].record(micros() - start);
+}
+
 // ============================================================================
 // MAIN SETUP AND LOOP
 // ============================================================================
 
+/*
+ * Task layout
+ *
+ *   task      core     priority  stack  role
+ *   signal    APP_CPU  10        4 KB   capture and replay; sole user of the signal pins
+ *   web       PRO_CPU  5         8 KB   WebServer and event stream, beside WiFi (23) and lwIP (18)
+ *   loopTask  APP_CPU  1         8 KB   loop(): status LED, failsafe, attack simulation flow
+ *   logDrain  any      1         4 KB   serial and flash output of the activity log
+ *
+ * Hardware work reaches the signal task only as jobs (see "Job
+ * scheduler"). Requests that start one answer 202 with the job id at once;
+ * the web task never waits for hardware I/O.
+ *
+ * Nothing polls on a fixed period. The web task sleeps in select() on the
+ * listening socket, the connection being served, subscribers with unsent
+ * data and webWakeFd, which the signal task writes when a request
+ * finishes. loop() sleeps on its task notification until the nearest of
+ * its own deadlines (LED blink, failsafe, the waits of its flows); state
+ * changes notify it so the deadlines are recomputed.
+ *
+ * Built with SINGLE_TASK_LAYOUT, one "signal" task does the signal and web
+ * work in turn and the web side is polled every WEB_POLL_INTERVAL_MS.
+ */
+
+// Sockets currently in listen state
+void findListenSockets(fd_set& listening) {
+    FD_ZERO(&listening);
+    for(int fd = 0; fd < FD_SETSIZE; fd++) {
+        int accepting = 0;
+        socklen_t length = sizeof(accepting);
+        if(getsockopt(fd, SOL_SOCKET, SO_ACCEPTCONN, &accepting, &length) == 0 && accepting) {
+            FD_SET(fd, &listening);
+        }
+    }
+}
+
+// WebServer keeps its listening socket private, so start it and take the
+// one listener that appeared across begin(). Listeners opened by anything
+// else are ignored; if begin() did not add exactly one, say so and return
+// -1 rather than guess.
+int beginWebServer() {
+    fd_set before, after;
+    findListenSockets(before);
+    server.begin();
+    findListenSockets(after);
+    
+    int found = -1;
+    int count = 0;
+    for(int fd = 0; fd < FD_SETSIZE; fd++) {
+        if(FD_ISSET(fd, &after) && !FD_ISSET(fd, &before)) {
+            found = fd;
+            count++;
+        }
+    }
+    if(count != 1) {
+        Serial.printf("[!] WebServer opened %d listening sockets, expected 1\n", count);
+        return -1;
+    }
+    return found;
+}
+
+// Sleep until the web task has something to do
+void waitForWebEvent() {
+    fd_set readable, writable;
+    FD_ZERO(&readable);
+    FD_ZERO(&writable);
+    int maxFd = -1;
+    unsigned long timeout = webListenFd >= 0 ? WEB_IDLE_WAIT_MS : WEB_POLL_INTERVAL_MS;
+    
+    auto watch = [&maxFd](int fd, fd_set& set) {
+        if(fd < 0) return;
+        FD_SET(fd, &set);
+        maxFd = max(maxFd, fd);
+    };
+    
+    watch(webWakeFd, readable);
+    watch(webListenFd, readable);
+    if(server.client().connected()) watch(server.client().fd(), readable);
+    
+    // Log and status changes are not signalled; subscribers get them
+    // within one coalescing interval
+    for(size_t i = 0; i < MAX_EVENT_CLIENTS; i++) {
+        EventClient& ec = eventClients[i];
+        if(!ec.active) continue;
+        timeout = min(timeout, (unsigned long)EVENT_STATUS_INTERVAL_MS);
+        if(ec.pendingLength > 0) watch(ec.client.fd(), writable);
+    }
+    
+    if(maxFd < 0) {
+        vTaskDelay(pdMS_TO_TICKS(timeout));
+        return;
+    }
+    
+    timeval wait = {(time_t)(timeout / 1000), (suseconds_t)(timeout % 1000) * 1000};
+    if(select(maxFd + 1, &readable, &writable, NULL, &wait) > 0 &&
+       webWakeFd >= 0 && FD_ISSET(webWakeFd, &readable)) {
+        uint64_t count;
+        if(read(webWakeFd, &count, sizeof(count)) < 0) return;
+    }
+}
+
+void webTask(void* param) {
+    for(;;) {
+        server.handleClient();
+        pumpEventClients();
+        waitForWebEvent();
+    }
+}
+
+#if SINGLE_TASK_LAYOUT
+// Signal I/O and the web server taking turns, as before the split. The
+// web side is polled; job submissions still wake the task early.
+void signalWebTask(void* param) {
+    for(;;) {
+        unsigned long wait = runSignalWork();
+        server.handleClient();
+        pumpEventClients();
+        if(wait) ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(min(wait, (unsigned long)WEB_POLL_INTERVAL_MS)));
+    }
+}
+#endif
+
 void setup() {
     Serial.begin(115200);
     Serial.println("\n\n===========================================");
@@ -758,24 +4091,59 @@ void setup() {
     Serial.println("Educational Demonstration System");
     Serial.println("===========================================\n");
     
+    revisionBase = (esp_random() & 0x7fff0000UL) | 1;
+    statusRevision.store(revisionBase);
+    signalsRevision = revisionBase;
+    
+    // Flash event log; sequence numbers continue from the last boot
+    logStoreMutex = xSemaphoreCreateMutex();
+    logStoreReady = logStoreBegin();
+    if(logStoreReady) {
+        Serial.printf("[✓] Event log mounted, next sequence %lu\n", (unsigned long)logSequenceBase);
+    } else {
+        Serial.println("[✗] Event log unavailable, history kept in RAM only");
+    }
+    
+    // Signal store, job scheduler and the signal I/O task. setup() runs on loopTask.
+    loopTaskHandle = xTaskGetCurrentTaskHandle();
+    storeWriteMutex = xSemaphoreCreateMutex();
+    storeBegin();
+    jobsMutex = xSemaphoreCreateMutex();
+    #if !SINGLE_TASK_LAYOUT
+    xTaskCreatePinnedToCore(signalTask, "signal", SIGNAL_TASK_STACK_SIZE, NULL,
+                            SIGNAL_TASK_PRIORITY, &signalTaskHandle, SIGNAL_TASK_CORE);
+    #endif
+    
+    // Serial output of the activity log is deferred to this task
+    xTaskCreate(logDrainTask, "logDrain", LOG_DRAIN_STACK_SIZE, NULL,
+                LOG_DRAIN_TASK_PRIORITY, NULL);
+    
     // Initialize pins
     pinMode(STATUS_LED_PIN, OUTPUT);
     digitalWrite(STATUS_LED_PIN, LOW);
     
+    // Transmitter output trims from the last calibration
+    loadCalibration();
+    
     #if ENABLE_IR_MODULE
     pinMode(IR_RECV_PIN, INPUT);
-    pinMode(IR_SEND_PIN, OUTPUT);
-    digitalWrite(IR_SEND_PIN, LOW);
-    Serial.println("[✓] IR module enabled");
+    attachInterrupt(digitalPinToInterrupt(IR_RECV_PIN), onIRFrameStart, FALLING);
+    if(beginTransmitter(SIGNAL_TYPE_IR, IR_SEND_PIN)) {
+        Serial.println("[✓] IR module enabled");
+    } else {
+        Serial.println("[✗] IR transmitter unavailable, capture only");
+    }
     #else
     Serial.println("[✗] IR module disabled");
     #endif
     
     #if ENABLE_RF_MODULE
     pinMode(RF_RECV_PIN, INPUT);
-    pinMode(RF_SEND_PIN, OUTPUT);
-    digitalWrite(RF_SEND_PIN, LOW);
-    Serial.println("[✓] RF module enabled");
+    if(beginTransmitter(SIGNAL_TYPE_RF, RF_SEND_PIN)) {
+        Serial.println("[✓] RF module enabled");
+    } else {
+        Serial.println("[✗] RF transmitter unavailable, capture only");
+    }
     #else
     Serial.println("[✗] RF module disabled");
     #endif
@@ -794,66 +4162,116 @@ void setup() {
     Serial.println(AP_PASSWORD);
     
     // Setup web server routes
-    server.on("/", handleRoot);
-    server.on("/api/status", handleStatus);
-    server.on("/api/capture", handleCapture);
-    server.on("/api/replay", handleReplay);
-    server.on("/api/attack/start", handleAttackStart);
-    server.on("/api/attack/stop", handleAttackStop);
+    server.on("/", metered<ENDPOINT_ROOT, handleRoot>);
+    server.on("/api/status", metered<ENDPOINT_STATUS, handleStatus>);
+    server.on("/api/signals", metered<ENDPOINT_SIGNALS, handleSignals>);
+    server.on(UriBraces("/api/signal/{}/timings"), metered<ENDPOINT_SIGNAL_TIMINGS, handleSignalTimings>);
+    server.on(UriBraces("/api/signal/{}/envelope"), metered<ENDPOINT_SIGNAL_ENVELOPE, handleSignalEnvelope>);
+    server.on(UriBraces("/api/signal/{}/carrier"), metered<ENDPOINT_SIGNAL_CARRIER, handleSignalCarrier>);
+    server.on("/api/log", metered<ENDPOINT_LOG, handleLog>);
+    server.on("/api/events", metered<ENDPOINT_EVENTS, handleEvents>);
+    server.on("/api/capture", metered<ENDPOINT_CAPTURE, handleCapture>);
+    server.on(UriBraces("/api/jobs/{}/cancel"), metered<ENDPOINT_JOB_CANCEL, handleJobCancel>);
+    server.on(UriBraces("/api/jobs/{}"), metered<ENDPOINT_JOB, handleJob>);
+    server.on("/api/replay", metered<ENDPOINT_REPLAY, handleReplay>);
+    server.on("/api/selftest", metered<ENDPOINT_SELFTEST, handleSelfTest>);
+    server.on("/api/calibrate", metered<ENDPOINT_CALIBRATE, handleCalibrate>);
+    server.on("/api/attack/start", metered<ENDPOINT_ATTACK_START, handleAttackStart>);
+    server.on("/api/attack/stop", metered<ENDPOINT_ATTACK_STOP, handleAttackStop>);
+    server.on("/metrics", metered<ENDPOINT_METRICS, handleMetrics>);
     
-    server.begin();
+    const char* collectedHeaders[] = {"If-None-Match", "Range"};
+    server.collectHeaders(collectedHeaders, 2);
+    
+    server.enableDelay(false);
+    webListenFd = beginWebServer();
+    esp_vfs_eventfd_config_t eventfdConfig = ESP_VFS_EVENTD_CONFIG_DEFAULT();
+    esp_vfs_eventfd_register(&eventfdConfig);
+    webWakeFd = eventfd(0, 0);
+    if(webListenFd < 0 || webWakeFd < 0) {
+        Serial.println("[!] Web task falling back to polling");
+    }
+    #if SINGLE_TASK_LAYOUT
+    xTaskCreatePinnedToCore(signalWebTask, "signal", SIGNAL_TASK_STACK_SIZE + WEB_TASK_STACK_SIZE, NULL,
+                            SIGNAL_TASK_PRIORITY, &signalTaskHandle, SIGNAL_TASK_CORE);
+    #else
+    xTaskCreatePinnedToCore(webTask, "web", WEB_TASK_STACK_SIZE, NULL,
+                            WEB_TASK_PRIORITY, NULL, WEB_TASK_CORE);
+    #endif
     Serial.println("\n[✓] Web server started");
     Serial.println("[✓] System ready");
     Serial.println("\nConnect to WiFi and navigate to: http://" + IP.toString());
     Serial.println("===========================================\n");
     
-    addActivityLog("System initialized");
+    LOG_EVENT(EVT_SYSTEM_INITIALIZED);
+}
+
+bool jobDone(uintptr_t id) {
+    return jobFinished(jobStatus(id));
+}
+
+/*
+ * Attack simulation
+ *
+ * Replays the stored signals in turn as background jobs, one at a time,
+ * starting each attackDelayMs after the last. A replay's finish wakes
+ * loop(). Cancelled, the flow cancels the replay it is waiting on.
+ */
+Flow attackFlow() {
+    size_t index = 0;
+    for(;;) {
+        unsigned long queuedAt = millis();
+        size_t stored = storedSignalCount();
+        SignalSummary target;
+        Job* job = NULL;
+        if(stored > 0 && findSignalSummary(NULL, index % stored, target)) {
+            job = submitJob(JOB_REPLAY, target.type, PRIORITY_BACKGROUND, attackDelayMs, target.id);
+        }
+        
+        if(job) {
+            uint32_t id = job->id;
+            index = (index + 1) % stored;
+            if(co_await flowUntil(jobDone, id, FLOW_FOREVER) == FLOW_CANCELLED) {
+                cancelJob(id);
+                co_return;
+            }
+        }
+        
+        long left = attackDelayMs - (long)(millis() - queuedAt);
+        if(co_await flowDelay(max(left, 0L)) == FLOW_CANCELLED) co_return;
+    }
 }
 
 void loop() {
-    server.handleClient();
+    uint32_t loopStart = micros();
+    unsigned long now = millis();
+    unsigned long wait = LOOP_IDLE_WAIT_MS;
+    uint8_t busy = busyResources.load();
     
     // Update LED status
-    setStatusLED(currentState);
-    
-    // Failsafe timeout check
-    if(currentState != STATE_IDLE) {
-        if(millis() - stateStartTime > FAILSAFE_TIMEOUT_MS) {
-            Serial.println("FAILSAFE: Operation timeout, returning to idle");
-            currentState = STATE_IDLE;
-            attackSimulationActive = false;
-            addActivityLog("FAILSAFE: Timeout triggered");
-        }
+    setStatusLED(busy);
+    if(busy & RESOURCES_RX) {
+        wait = min(wait, LED_BLINK_INTERVAL_MS - now % LED_BLINK_INTERVAL_MS);
     }
     
-    // Attack simulation logic
-    if(attackSimulationActive && !capturedSignals.empty()) {
-        unsigned long now = millis();
-        
-        if(now - lastAttackTime >= attackDelayMs) {
-            if(currentState == STATE_IDLE) {
-                currentState = STATE_REPLAYING;
-                
-                const RawSignal& signal = capturedSignals[attackSignalIndex];
-                
-                if(signal.type == SIGNAL_TYPE_IR) {
-                    #if ENABLE_IR_MODULE
-                    replayIRSignal(signal);
-                    #endif
-                } else {
-                    #if ENABLE_RF_MODULE
-                    replayRFSignal(signal);
-                    #endif
-                }
-                
-                // Move to next signal
-                attackSignalIndex = (attackSignalIndex + 1) % capturedSignals.size();
-                lastAttackTime = now;
-                
-                currentState = STATE_IDLE;
-            }
-        }
+    // Failsafe: cancel jobs running longer than FAILSAFE_TIMEOUT_MS
+    wait = min(wait, enforceFailsafe(now));
+    
+    // Attack simulation: a start (re)spawns its flow, a stop or the
+    // failsafe cancels it at its current wait
+    static uint32_t attackFlowId = 0;
+    static uint32_t attackFlowRun = 0;
+    uint32_t run = attackRun.load();
+    if(loopFlows.running(attackFlowId) && (!attackSimulationActive || run != attackFlowRun)) {
+        loopFlows.cancel(attackFlowId);
+        attackFlowId = 0;
+    }
+    if(attackSimulationActive && !loopFlows.running(attackFlowId)) {
+        loopFlows.spawn(attackFlow(), NULL, &attackFlowId);
+        attackFlowRun = run;
     }
+    wait = min(wait, loopFlows.run());
     
-    delay(10); // Small delay to prevent watchdog issues
+    metrics.loopLatency.record(micros() - loopStart);
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(wait));
 }
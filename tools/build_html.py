@@ -0,0 +1,93 @@
+#!/usr/bin/env python3
+"""
+Build the embedded web UI.
+
+Minifies web/index.html, gzips it and writes the result into main.cpp as a
+PROGMEM byte array between the GENERATED HTML_PAGE markers, together with a
+strong ETag derived from the SHA-256 of the compressed bytes. The output is
+deterministic (fixed gzip mtime), so the same page always yields the same
+array and ETag.
+
+Usage:
+    python3 tools/build_html.py           # regenerate main.cpp
+    python3 tools/build_html.py --check   # fail if main.cpp is out of date
+"""
+
+import argparse
+import gzip
+import hashlib
+import re
+import sys
+from pathlib import Path
+
+ROOT = Path(__file__).resolve().parent.parent
+SOURCE = ROOT / "web" / "index.html"
+TARGET = ROOT / "main.cpp"
+
+BEGIN_MARKER = "// BEGIN GENERATED HTML_PAGE"
+END_MARKER = "// END GENERATED HTML_PAGE"
+
+
+def minify(html):
+    """Conservative minification that is safe for the inline CSS and JS."""
+    parts = re.split(r"(<script>.*?</script>|<style>.*?</style>)", html, flags=re.S)
+    out = []
+    for part in parts:
+        if part.startswith("<script>"):
+            # Keep line breaks so automatic semicolon insertion is unaffected
+            lines = [line.strip() for line in part.splitlines()]
+            out.append("\n".join(l for l in lines if l and not l.startswith("//")))
+        elif part.startswith("<style>"):
+            css = " ".join(part.split())
+            out.append(re.sub(r"\s*([{};:,>])\s*", r"\1", css).replace(";}", "}"))
+        else:
+            out.append(re.sub(r">\s+<", "><", " ".join(part.split())))
+    return "".join(out)
+
+
+def render(payload, etag):
+    rows = []
+    for offset in range(0, len(payload), 16):
+        chunk = payload[offset:offset + 16]
+        rows.append("    " + ", ".join("0x%02x" % b for b in chunk) + ",")
+    return "\n".join([
+        BEGIN_MARKER + " (tools/build_html.py from web/index.html, do not edit)",
+        "const uint8_t HTML_PAGE_GZ[] PROGMEM = {",
+        *rows,
+        "};",
+        '#define HTML_PAGE_ETAG "\\"%s\\""' % etag,
+        END_MARKER,
+    ])
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("--check", action="store_true",
+                        help="exit non-zero if main.cpp is not up to date")
+    args = parser.parse_args()
+
+    html = SOURCE.read_text(encoding="utf-8")
+    minified = minify(html).encode("utf-8")
+    payload = gzip.compress(minified, compresslevel=9, mtime=0)
+    etag = hashlib.sha256(payload).hexdigest()[:16]
+
+    source = TARGET.read_text(encoding="utf-8")
+    begin = source.find(BEGIN_MARKER)
+    end = source.find(END_MARKER)
+    if begin < 0 or end < 0:
+        sys.exit("build_html: GENERATED HTML_PAGE markers not found in main.cpp")
+    updated = source[:begin] + render(payload, etag) + source[end + len(END_MARKER):]
+
+    if args.check:
+        if updated != source:
+            sys.exit("build_html: main.cpp is stale, run tools/build_html.py")
+        return
+
+    if updated != source:
+        TARGET.write_text(updated, encoding="utf-8")
+    print("build_html: %d bytes -> %d minified -> %d gzip, ETag %s"
+          % (len(html.encode("utf-8")), len(minified), len(payload), etag))
+
+
+if __name__ == "__main__":
+    main()